@@ -21,6 +21,7 @@
 import re
 import sys	
 import egret_ext
+import egret_result
 from optparse import OptionParser
 #import time
 
@@ -35,6 +36,8 @@ parser.add_option("-d", "--debug", action = "store_true", dest = "debugMode",
     default = False, help = "display debug info")
 parser.add_option("-s", "--stat", action = "store_true", dest = "statMode",
     default = False, help = "display stats")
+parser.add_option("-m", "--max_alerts", type = "int", dest = "maxAlerts",
+    default = 0, help = "stop after this many violations (0 for no limit)")
 opts, args = parser.parse_args()
 
 # check for valid command lines
@@ -58,18 +61,23 @@ else:
   regexStr = input("Enter a Regular Expression: ")
 
 # compile the regular expression
+status = None
 try: 
-  hasError = False
   regex = re.compile(regexStr)
 
   # execute regex-test
   # start_time = time.process_time()
-  alerts = egret_ext.run(regexStr, "evil", True, False, opts.debugMode, opts.statMode)
+  result = egret_ext.analyze(regexStr, "evil", True, opts.debugMode,
+    opts.statMode, False, opts.maxAlerts)
+  alerts = result["alerts"]
+  if opts.statMode:
+    egret_result.print_stats(result["stats"])
   # elapsed_time = time.process_time() - start_time
 
 except re.error as e:
   status = "ERROR (compiler error): Regular expression did not compile: " + str(e) + "\n"
-  alerts = [ status ]
+except egret_ext.error as e:
+  status = str(e)
 
 #if opts.statMode:
 #  fmt = "{0:30}| {1}"
@@ -85,106 +93,67 @@ if opts.outputFile:
 else:
   print(header, end='')
 
+# writes a line to the output
+def output(line):
+  if opts.outputFile:
+    outFile.write(line)
+    outFile.write('\n')
+  else:
+    print(line)
+
+exampleStatus = "ATTENTION: EXAMPLE STRING NOT ACCEPTED"
+
+# writes an alert, leaving out examples that are not accepted and fixes
+# that do not compile (unless in warn mode)
+def write_alert(alert):
+  output(egret_result.alert_header(alert))
+
+  # anchor examples are only shown if both strings are accepted
+  details = alert["details"]
+  if alert["type"] == "anchor usage":
+    success = [ re.fullmatch(regexStr, value) != None for (label, value) in details ]
+    if all(success) or opts.warnMode:
+      for ((label, value), accepted) in zip(details, success):
+        output(egret_result.alert_line(label, value))
+        if not accepted:
+          output(exampleStatus)
+  else:
+    for (label, value) in details:
+      output(egret_result.alert_line(label, value))
+
+  if alert["loc1"] != None:
+    output(egret_result.alert_line("Regex",
+      egret_result.mark_regex(regexStr, alert, egret_result.TERM_MARK)))
+
+  if alert["suggest"] != None:
+    line = egret_result.alert_line("Suggested fix", alert["suggest"])
+    try:
+      r = re.compile(alert["suggest"])
+      output(line)
+    except re.error as e:
+      if opts.warnMode:
+        output(line)
+        output("ATTENTION: SUGGESTED FIX DID NOT COMPILE: "  + str(e))
+
+  if alert["example"] != None:
+    line = egret_result.alert_line("Example accepted string", alert["example"])
+    if re.fullmatch(regexStr, alert["example"]) != None:
+      output(line)
+    elif opts.warnMode:
+      output(line)
+      output(exampleStatus)
+
+  output("")
+
 # write the alerts
-for s in alerts:
-
-  lines = s.split("\n")
-  prevLine = ""
-  for line in lines: 
-
-    suppressLine = False
-    example = False
-    anchorExample = False
-    if re.match("\.\.\.String with", line) != None:
-      example = True
-      anchorExample = True
-    if re.match("\.\.\.Example", line) != None:
-      example = True
-
-    if example:
-      suppressLine = True
-      first, second = line.split(':', 1)
-      exampleStr = second[1:]
-      success = re.fullmatch(regexStr, exampleStr) != None
-      if anchorExample:
-        if prevLine != "":
-          if prevSuccess and success: # both anchor examples successful
-            if opts.outputFile:
-              outFile.write(prevLine)
-              outFile.write('\n')
-              outFile.write(line)
-              outFile.write('\n')
-            else:
-              print(prevLine)
-              print(line)
-          else: # one line failed
-            if opts.warnMode:
-              status = "ATTENTION: EXAMPLE STRING NOT ACCEPTED"
-              if opts.outputFile:
-                outFile.write(prevLine)
-                outFile.write('\n')
-                if not prevSuccess:
-                  outFile.write(status)
-                  outFile.write('\n')
-                outFile.write(line)
-                outFile.write('\n')
-                if not success:
-                  outFile.write(status)
-                  outFile.write('\n')
-              else:
-                print(prevLine)
-                if not prevSuccess:
-                  print(status)
-                print(line)
-                if not success:
-                  print(status)
-          prevLine = ""
-        else:  # prevLine == ""
-          prevLine = line
-          prevSuccess = success
-      else:  # example but not anchor example
-        prevLine = ""
-        if success:
-          suppressLine = False
-        else:
-          if opts.warnMode:
-            status = "ATTENTION: EXAMPLE STRING NOT ACCEPTED"
-            if opts.outputFile:
-              outFile.write(line)
-              outFile.write('\n')
-              outFile.write(status)
-              outFile.write('\n')
-            else:
-              print(line)
-              print(status)
-    else: # not example
-      prevLine = ""
-
-    if re.match("\.\.\.Suggested fix", line) != None:
-      first, second = line.split(':', 1)
-      fixStr = second[1:]
-
-      try:
-        r = re.compile(fixStr)
-      except re.error as e:
-        suppressLine = True
-        if opts.warnMode:
-          status = "ATTENTION: SUGGESTED FIX DID NOT COMPILE: "  + str(e)
-          if opts.outputFile:
-            outFile.write(line)
-            outFile.write('\n')
-            outFile.write(status)
-            outFile.write('\n')
-          else:
-            print(line)
-            print(status)
-
-    if not suppressLine:
-      if opts.outputFile:
-        outFile.write(line)
-        outFile.write('\n')
-      else:
-        print(line)
+if status != None:
+  for line in status.split("\n"):
+    output(line)
+elif len(alerts) == 0:
+  output("No violations detected.")
+else:
+  for alert in alerts:
+    write_alert(alert)
 
 # close the output
 if opts.outputFile:
@@ -21,6 +21,7 @@
 import re
 import sys	
 import egret_ext
+import egret_result
 from optparse import OptionParser
 #import time
 
@@ -110,29 +111,25 @@ try:
 
     # execute regex-test
     #start_time = time.process_time()
-    inputStrs = egret_ext.run(regexStr, opts.baseSubstring,
-        False, False, opts.debugMode, opts.statMode)
-    status = inputStrs[0]
-    hasError = (status[0:5] == "ERROR")
+    result = egret_ext.analyze(regexStr, opts.baseSubstring,
+        False, opts.debugMode, opts.statMode)
+    hasError = False
+    if opts.statMode:
+        egret_result.print_stats(result["stats"])
 
 except re.error as e:
     status = "ERROR (compiler error): Regular expression did not compile: " + str(e)
     hasError = True
+except egret_ext.error as e:
+    status = str(e)
+    hasError = True
 
 if hasError:
     alerts = [status]
 else:
-    idx = 0
-    line = inputStrs[idx]
-    while line != "BEGIN":
-        idx += 1;
-        line = inputStrs[idx]
-    if idx == 0:
-        alerts = []
-        inputStrs = inputStrs[1:]
-    else:
-        alerts = inputStrs[:idx]
-        inputStrs = inputStrs[idx+1:]
+    alerts = [ egret_result.format_alert(regexStr, a, "\n", egret_result.TERM_MARK)
+        for a in result["alerts"] ]
+    inputStrs = result["test_strings"]
 
 if not hasError:
 
@@ -0,0 +1,78 @@
+# egret_result.py: Formats results returned by egret_ext
+#
+# Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+# elarson@seattleu.edu
+# 
+# This file is part of EGRET.
+# 
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+# 
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Highlight markers for the terminal and the web interface
+TERM_MARK = ("\033[33;44;1m", "\033[0m")
+WEB_MARK = ("<mark>", "</mark>")
+
+# Returns the regex with the alert locations highlighted. Locations are byte
+# offsets into the UTF-8 encoded regex.
+def mark_regex(regexStr, alert, mark):
+    regex = regexStr.encode("utf-8")
+    locs = [ loc for loc in (alert["loc1"], alert["loc2"]) if loc != None ]
+    starts = [ loc[0] for loc in locs ]
+    ends = [ loc[1] for loc in locs ]
+    marked = b""
+    for i in range(len(regex)):
+        if i in starts:
+            marked += mark[0].encode("utf-8")
+        marked += regex[i:i+1]
+        if i in ends:
+            marked += mark[1].encode("utf-8")
+    return marked.decode("utf-8", "replace")
+
+# Returns the first line of an alert
+def alert_header(alert):
+    if alert["warning"]:
+        header = "WARNING ("
+    else:
+        header = "VIOLATION ("
+    return header + alert["type"] + "): " + alert["message"]
+
+# Returns an alert detail line such as "...Suggested fix: a|b"
+def alert_line(label, value):
+    return "..." + label + ": " + value
+
+# Returns the lines of an alert
+def alert_lines(regexStr, alert, mark):
+    lines = [ alert_header(alert) ]
+    for (label, value) in alert["details"]:
+        lines.append(alert_line(label, value))
+    if alert["loc1"] != None:
+        lines.append(alert_line("Regex", mark_regex(regexStr, alert, mark)))
+    if alert["suggest"] != None:
+        lines.append(alert_line("Suggested fix", alert["suggest"]))
+    if alert["example"] != None:
+        lines.append(alert_line("Example accepted string", alert["example"]))
+    return lines
+
+# Returns an alert as text, each line is followed by the line break
+def format_alert(regexStr, alert, lb, mark):
+    return lb.join(alert_lines(regexStr, alert, mark)) + lb
+
+# Prints the stats, with a divider line between different tags
+def print_stats(stats):
+    fmt = "{0:30}| {1}"
+    prevTag = ""
+    for (tag, name, value) in stats:
+        if tag != prevTag and prevTag != "":
+            print("-" * 38)
+        print(fmt.format(name, value))
+        prevTag = tag
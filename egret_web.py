@@ -40,16 +40,7 @@ app = Flask(__name__)
 app.config.from_object(__name__)
 app.config['UPLOAD_FOLDER'] = UPLOAD_FOLDER
 
-def run_acre(regex):
-  if regex != '':
-    (result, errorMsg) = egret_web_api.run_acre(regex)
-    if result:
-      result = Markup(result)
-    return (result, errorMsg)
-
-  return (None, None)
-
-def run_egret(regex):
+def run_tools(regex):
   global test_strings
   global egret
 
@@ -93,12 +84,17 @@ def run_egret(regex):
   else:
     baseSubstr = 'evil'
       
+  # run acre and egret on the same engine pipeline
   if regex != '':
-    (egret['passList'], egret['failList'], egret['errorMsg'], egret['warnings']) = \
-      egret_web_api.run_egret(regex, baseSubstr, test_strings)
+    ((egret['passList'], egret['failList'], egret['errorMsg'], egret['warnings']), \
+      (acre_result, acre_error)) = \
+      egret_web_api.run_egret_acre(regex, baseSubstr, test_strings)
+    if acre_result:
+      acre_result = Markup(acre_result)
   else:
     (egret['passList'], egret['failList'], egret['errorMsg'], egret['warnings']) = \
       ([], [], None, None)
+    (acre_result, acre_error) = (None, None)
 
   if egret['warnings']:
     egret['warnings'] = Markup(egret['warnings'])
@@ -117,6 +113,8 @@ def run_egret(regex):
     egret['testResult'] = egret_web_api.run_test_string(regex, egret['testString'])
   else:
     egret['testResult'] = ''
+
+  return (acre_result, acre_error)
     
 def allowed_file(filename):
   return '.' in filename and filename.rsplit('.', 1)[1] in ALLOWED_EXTENSIONS
@@ -132,8 +130,7 @@ def process_submit():
     regex = ''
 
   # run tools
-  (acre_result, acre_error) = run_acre(regex)
-  run_egret(regex)
+  (acre_result, acre_error) = run_tools(regex)
     
   # render webpage
   return render_template('egret.html', regex=regex, egret=egret, test_strings=test_strings, \
@@ -20,6 +20,7 @@
 
 import re
 import egret_ext
+import egret_result
 
 def run_egret(regexStr, baseSubstring, testList):
     try:
@@ -28,32 +29,57 @@ def run_egret(regexStr, baseSubstring, testList):
         status = "ERROR (compiler error): Regular expression did not compile: " + str(e)
         return ([], [], status, [])
         
-    inputStrs = egret_ext.run(regexStr, baseSubstring, False, True, False, False)
+    try:
+        result = egret_ext.analyze(regexStr, baseSubstring, False)
+    except egret_ext.error as e:
+        return ([], [], str(e), [])
+    return process_egret_output(regex, regexStr, result, testList)
+
+# Compiled regex from the previous call, the web interface runs the same
+# regex again on every button press
+compiled = None
+
+def get_compiled(regexStr):
+    global compiled
+    if compiled == None or compiled[0] != regexStr:
+        compiled = (regexStr, egret_ext.Regex(regexStr))
+    return compiled[1]
+
+# Runs ACRE and EGRET on a single compiled regex, returns the results of
+# run_egret and run_acre
+def run_egret_acre(regexStr, baseSubstring, testList):
+    try:
+        regex = re.compile(regexStr)
+    except re.error as e:
+        status = "ERROR (compiler error): Regular expression did not compile: " + str(e)
+        return (([], [], status, []), (None, status))
 
-    idx = 0
-    line = inputStrs[idx]
-    if line[0:5] == "ERROR":
-        return ([], [], line, [])
+    try:
+        engine = get_compiled(regexStr)
+    except egret_ext.error as e:
+        return (([], [], str(e), []), (None, str(e)))
 
-    while line != "BEGIN":
-      idx += 1;
-      line = inputStrs[idx]
+    try:
+        egretResult = process_egret_output(regex, regexStr,
+            engine.generate(baseSubstring), testList)
+    except egret_ext.error as e:
+        egretResult = ([], [], str(e), [])
+    try:
+        acreResult = process_acre_output(regexStr, engine.check(baseSubstring))
+    except egret_ext.error as e:
+        acreResult = (None, str(e))
 
-    if idx == 0:
-      alerts = []
-      inputStrs = inputStrs[1:]
-    else:
-      alerts = inputStrs[:idx]
-      inputStrs = inputStrs[idx+1:]
+    return (egretResult, acreResult)
 
+def process_egret_output(regex, regexStr, result, testList):
     warnings = ""
-    for a in alerts:
-      warnings += a
+    for a in result["alerts"]:
+      warnings += egret_result.format_alert(regexStr, a, "<br>", egret_result.WEB_MARK)
 
     matches = []
     nonMatches = []
 
-    inputStrs = sorted(list(set(inputStrs) | set(testList)))
+    inputStrs = sorted(list(set(result["test_strings"]) | set(testList)))
     
     for inputStr in inputStrs:
         search = regex.fullmatch(inputStr)
@@ -124,65 +150,48 @@ def run_acre(regexStr):
     errorMsg = "ERROR (compiler error): Regular expression did not compile: " + str(e)
     return (None, errorMsg)
         
-  alerts = egret_ext.run(regexStr, "evil", True, True, False, False)
-
-  first_line = alerts[0]
-  if first_line[0:5] == "ERROR":
-    return (None, first_line)
-
-  status = ""
-  for s in alerts:
-
-    lines = s.split("<br>")
-    prevLine = ""
-    for line in lines: 
-
-      suppressLine = False
-      example = False
-      anchorExample = False
-      if re.match("\.\.\.String with", line) != None:
-        example = True
-        anchorExample = True
-      if re.match("\.\.\.Example", line) != None:
-        example = True
-
-      if example:
-        suppressLine = True
-        first, second = line.split(':', 1)
-        exampleStr = second[1:]
-        success = re.fullmatch(regexStr, exampleStr) != None
-        if anchorExample:
-          if prevLine != "":
-            if prevSuccess and success: # both anchor examples successful
-              status += prevLine
-              status += '<br>'
-              status += line
-              status += '<br>'
-            prevLine = ""
-          else:  # prevLine == ""
-            prevLine = line
-            prevSuccess = success
-        else:  # example but not anchor example
-          prevLine = ""
-          if success:
-            suppressLine = False
-      else: # not example
-        prevLine = ""
-
-      if re.match("\.\.\.Suggested fix", line) != None:
-        first, second = line.split(':', 1)
-        fixStr = second[1:]
-
-        try:
-          r = re.compile(fixStr)
-        except re.error as e:
-          suppressLine = True
-
-      if not suppressLine:
-        status += line
-        status += '<br>'
+  try:
+    result = egret_ext.analyze(regexStr, "evil", True)
+  except egret_ext.error as e:
+    return (None, str(e))
+  return process_acre_output(regexStr, result)
+
+# Leaves out examples that are not accepted and fixes that do not compile
+def process_acre_output(regexStr, result):
+  if len(result["alerts"]) == 0:
+    return ("No violations detected.", None)
+
+  lines = []
+  for alert in result["alerts"]:
+    lines.append(egret_result.alert_header(alert))
+
+    # anchor examples are only shown if both strings are accepted
+    details = alert["details"]
+    if alert["type"] != "anchor usage" or \
+        all(re.fullmatch(regexStr, value) != None for (label, value) in details):
+      for (label, value) in details:
+        lines.append(egret_result.alert_line(label, value))
+
+    if alert["loc1"] != None:
+      lines.append(egret_result.alert_line("Regex",
+        egret_result.mark_regex(regexStr, alert, egret_result.WEB_MARK)))
+
+    if alert["suggest"] != None:
+      try:
+        r = re.compile(alert["suggest"])
+        lines.append(egret_result.alert_line("Suggested fix", alert["suggest"]))
+      except re.error as e:
+        pass
+
+    if alert["example"] != None:
+      if re.fullmatch(regexStr, alert["example"]) != None:
+        lines.append(egret_result.alert_line("Example accepted string",
+          alert["example"]))
+
+    lines.append("")
 
   # get rid of line breaks at end (eliminates extra space at the end)
+  status = "<br>".join(lines)
   while (status[-4:] == "<br>"):
     status = status[0:-4]
 
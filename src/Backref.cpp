@@ -24,11 +24,10 @@
 #include <set>
 #include <string>
 
-void Backref::gen_min_iter_string(std::string &min_iter_string) {
-  min_iter_string.append(get_substring());
-}
-
-std::vector<std::string> Backref::gen_evil_strings(const std::string& test_string) {
+std::vector<std::string>
+Backref::gen_evil_strings(const std::string &test_string,
+                          const std::string &prefix,
+                          const std::string &substring) {
   std::vector<std::string> evil_strings;
   return evil_strings;
 
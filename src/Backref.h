@@ -36,21 +36,14 @@ public:
     group_loc = l;
   }
 
-  // setters
-  void set_curr_prefix(std::string s) { curr_prefix = std::move(s); }
-  void set_curr_substring(std::string s) { curr_substring = std::move(s); }
-  void set_prefix_from_curr() { prefix = curr_prefix; }
-  void set_substring_from_curr() { substring = curr_substring; }
-
   // getters
   Location get_group_loc() { return group_loc; }
-  std::string get_substring() { return substring; }
-
-  // generate minimum iteration string
-  void gen_min_iter_string(std::string &min_iter_string);
 
-  // generate evil strings
-  std::vector<std::string> gen_evil_strings(const std::string& test_string);
+  // generate evil strings, prefix is the path string before the
+  // backreference and substring is the text it repeats
+  std::vector<std::string> gen_evil_strings(const std::string &test_string,
+                                            const std::string &prefix,
+                                            const std::string &substring);
 
   // print the regex loop
   void print();
@@ -60,13 +53,6 @@ private:
       group_name;     // name of group (blank if using numbered backreference)
   int group_number;   // number of group
   Location group_loc; // location of group
-
-  std::string prefix;    // prefix of test string before the backreference
-  std::string substring; // substring corresponding to backreference
-
-  std::string curr_prefix; // current path string up to visiting this node
-  std::string
-      curr_substring; // current substring corresponding to this backreference
 };
 
 #endif // BACKREF_H
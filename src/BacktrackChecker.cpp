@@ -0,0 +1,659 @@
+/*  BacktrackChecker.cpp: detects catastrophic backtracking (ReDoS)
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BacktrackChecker.h"
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+// Limits on the amount of work done by the ambiguity searches
+static const unsigned long MAX_PRODUCT_EDGES = 4000000;
+static const unsigned long MAX_TRIPLE_STEPS = 1000000;
+
+std::string BacktrackAttack::gen_attack_string(unsigned int pumps) const {
+  std::string attack = prefix;
+  for (unsigned int i = 0; i < pumps; i++)
+    attack += pump;
+  return attack + suffix;
+}
+
+BacktrackChecker::BacktrackChecker(const NFA &nfa) : automaton(nfa) {
+  num_states = automaton.get_num_states();
+  initial = automaton.get_initial();
+  cut_offs = 0;
+
+  // strongly connected components of the character level automaton
+  std::vector<std::vector<unsigned int>> graph = automaton.get_epsilons();
+  for (const CharAutomaton::Transition &t : automaton.get_transitions())
+    graph[t.from].push_back(t.to);
+  char_scc = find_sccs(graph);
+
+  remove_epsilons();
+}
+
+void BacktrackChecker::remove_epsilons() {
+  const std::vector<std::vector<unsigned int>> &eps = automaton.get_epsilons();
+  const std::vector<CharAutomaton::Transition> &char_trans =
+      automaton.get_transitions();
+  const std::vector<std::vector<unsigned int>> &char_out =
+      automaton.get_transitions_out();
+
+  // states that can be reached after consuming a character
+  std::vector<bool> important(num_states, false);
+  important[initial] = true;
+  for (const CharAutomaton::Transition &t : char_trans)
+    important[t.to] = true;
+
+  out.assign(num_states, std::vector<unsigned int>());
+  accepting.assign(num_states, false);
+  std::vector<unsigned int> count(num_states, 0);
+  std::vector<unsigned int> reached;
+  std::vector<unsigned int> stack;
+
+  for (unsigned int p = 0; p < num_states; p++) {
+    if (!important[p])
+      continue;
+
+    // count epsilon paths from p to each state, stopping at two since that
+    // is enough to make the matcher explore the same input twice
+    stack.push_back(p);
+    while (!stack.empty()) {
+      unsigned int r = stack.back();
+      stack.pop_back();
+      if (count[r] == 0)
+        reached.push_back(r);
+      if (++count[r] > 2)
+        continue;
+      for (unsigned int next : eps[r])
+        stack.push_back(next);
+    }
+
+    std::sort(reached.begin(), reached.end());
+    for (unsigned int r : reached) {
+      if (r == automaton.get_final())
+        accepting[p] = true;
+      for (unsigned int i : char_out[r]) {
+        Transition t;
+        t.from = p;
+        t.to = char_trans[i].to;
+        t.label = char_trans[i].label;
+        t.loc = char_trans[i].loc;
+        t.mult = std::min(count[r], 2u);
+        out[p].push_back(trans.size());
+        trans.push_back(t);
+      }
+      count[r] = 0;
+    }
+    reached.clear();
+  }
+
+  std::vector<std::vector<unsigned int>> graph(num_states);
+  for (const Transition &t : trans)
+    graph[t.from].push_back(t.to);
+  scc = find_sccs(graph);
+}
+
+std::vector<BacktrackAttack> BacktrackChecker::find_attacks() {
+  std::vector<BacktrackAttack> attacks;
+
+  // group states into components, keeping only those with a cycle
+  int num_sccs = 0;
+  for (int id : scc)
+    num_sccs = std::max(num_sccs, id + 1);
+  std::vector<std::vector<unsigned int>> components(num_sccs);
+  std::vector<bool> cyclic(num_sccs, false);
+  for (const Transition &t : trans) {
+    if (scc[t.from] == scc[t.to])
+      cyclic[scc[t.from]] = true;
+  }
+  for (unsigned int s = 0; s < num_states; s++) {
+    if (!out[s].empty() || s == initial)
+      components[scc[s]].push_back(s);
+  }
+
+  // exponential ambiguity within a single component
+  std::vector<bool> exponential(num_sccs, false);
+  for (int id = 0; id < num_sccs; id++) {
+    if (!cyclic[id])
+      continue;
+    BacktrackAttack attack;
+    if (find_exponential(components[id], attack) && find_suffix(attack)) {
+      exponential[id] = true;
+      if (!reported(attacks, attack))
+        attacks.push_back(attack);
+    }
+  }
+
+  // polynomial ambiguity between two components
+  unsigned long budget = MAX_TRIPLE_STEPS;
+  for (int id1 = 0; id1 < num_sccs; id1++) {
+    if (!cyclic[id1] || exponential[id1])
+      continue;
+    std::vector<bool> reach(num_states, false);
+    std::vector<unsigned int> work(1, components[id1][0]);
+    while (!work.empty()) {
+      unsigned int s = work.back();
+      work.pop_back();
+      for (unsigned int i : out[s]) {
+        if (!reach[trans[i].to]) {
+          reach[trans[i].to] = true;
+          work.push_back(trans[i].to);
+        }
+      }
+    }
+
+    bool found = false;
+    for (int id2 = 0; id2 < num_sccs && !found && budget > 0; id2++) {
+      if (id1 == id2 || !cyclic[id2] || exponential[id2] ||
+          !reach[components[id2][0]])
+        continue;
+      for (unsigned int p : components[id1]) {
+        for (unsigned int q : components[id2]) {
+          BacktrackAttack attack;
+          if (find_polynomial(p, q, budget, attack) && find_suffix(attack)) {
+            if (!reported(attacks, attack))
+              attacks.push_back(attack);
+            found = true;
+            break;
+          }
+        }
+        if (found || budget == 0)
+          break;
+      }
+    }
+  }
+
+  return attacks;
+}
+
+std::vector<BacktrackAttack> BacktrackChecker::gen_repeat_attacks() {
+  std::vector<BacktrackAttack> ambiguous = find_attacks();
+  std::vector<BacktrackAttack> attacks;
+
+  for (const CharAutomaton::BackEdge &back : automaton.get_back_edges()) {
+    // unrolled loops have several back edges for the same repetition
+    auto same_loc = [&back](const BacktrackAttack &a) {
+      return a.loc1 == back.loc;
+    };
+    if (std::any_of(attacks.begin(), attacks.end(), same_loc))
+      continue;
+    auto it = std::find_if(ambiguous.begin(), ambiguous.end(), same_loc);
+    if (it != ambiguous.end()) {
+      attacks.push_back(*it);
+      continue;
+    }
+
+    // pump one iteration of the repetition: from its start to its end
+    BacktrackAttack attack;
+    attack.exponential = false;
+    attack.loc1 = back.loc;
+    attack.loc2 = std::make_pair(-1, -1);
+    if (!find_char_string(initial, back.to, false, attack.prefix) ||
+        !find_char_string(back.to, back.from, true, attack.pump) ||
+        !find_suffix(attack))
+      continue;
+    attacks.push_back(attack);
+  }
+
+  return attacks;
+}
+
+bool BacktrackChecker::find_exponential(
+    const std::vector<unsigned int> &component, BacktrackAttack &attack) {
+  int id = scc[component[0]];
+  attack.exponential = true;
+  attack.loc1 = repeat_loc(component[0]);
+
+  // a transition reached by two epsilon paths, or two overlapping
+  // transitions between the same pair of states
+  for (unsigned int p : component) {
+    for (unsigned int i = 0; i < out[p].size(); i++) {
+      const Transition &t1 = trans[out[p][i]];
+      if (scc[t1.to] != id)
+        continue;
+      CharLabel common;
+      if (t1.mult >= 2)
+        common = t1.label;
+      for (unsigned int j = i + 1; j < out[p].size() && common.none(); j++) {
+        const Transition &t2 = trans[out[p][j]];
+        if (t2.to == t1.to)
+          common = t1.label & t2.label;
+      }
+      if (common.none())
+        continue;
+
+      std::string rest;
+      if (!find_string(t1.to, p, true, rest) ||
+          !find_string(initial, p, false, attack.prefix))
+        continue;
+      attack.pump = pick_char(common) + rest;
+      attack.loc2 = t1.loc;
+      return true;
+    }
+  }
+
+  // product automaton: two runs on the same string that split apart and
+  // join again
+  unsigned long num_trans = 0;
+  std::vector<unsigned int> local(num_states, 0);
+  for (unsigned int k = 0; k < component.size(); k++) {
+    local[component[k]] = k;
+    num_trans += out[component[k]].size();
+  }
+  if (num_trans * num_trans > MAX_PRODUCT_EDGES) {
+    cut_offs++;
+    return false;
+  }
+
+  unsigned int k = component.size();
+  std::vector<std::vector<unsigned int>> graph(k * k);
+  std::vector<std::vector<std::pair<char, unsigned int>>> info(k * k);
+  for (unsigned int x : component) {
+    for (unsigned int y : component) {
+      unsigned int node = local[x] * k + local[y];
+      for (unsigned int i : out[x]) {
+        if (scc[trans[i].to] != id)
+          continue;
+        for (unsigned int j : out[y]) {
+          if (scc[trans[j].to] != id)
+            continue;
+          CharLabel common = trans[i].label & trans[j].label;
+          if (common.none())
+            continue;
+          graph[node].push_back(local[trans[i].to] * k + local[trans[j].to]);
+          info[node].push_back(std::make_pair(pick_char(common), i));
+        }
+      }
+    }
+  }
+
+  std::vector<int> product_scc = find_sccs(graph);
+  for (unsigned int d = 0; d < k; d++) {
+    unsigned int diag = d * k + d;
+    for (unsigned int node = 0; node < k * k; node++) {
+      if (node / k == node % k || product_scc[node] != product_scc[diag])
+        continue;
+
+      // walk diag -> node -> diag within the product component
+      std::string pump;
+      Location loc2 = std::make_pair(-1, -1);
+      unsigned int targets[2] = {node, diag};
+      unsigned int start = diag;
+      for (unsigned int target : targets) {
+        std::vector<int> parent(k * k, -1);
+        std::vector<std::pair<char, unsigned int>> via(k * k);
+        std::queue<unsigned int> work;
+        work.push(start);
+        parent[start] = start;
+        bool reached = false;
+        while (!work.empty() && !reached) {
+          unsigned int curr = work.front();
+          work.pop();
+          for (unsigned int e = 0; e < graph[curr].size(); e++) {
+            unsigned int next = graph[curr][e];
+            if (parent[next] != -1 && next != target)
+              continue;
+            if (product_scc[next] != product_scc[diag])
+              continue;
+            parent[next] = curr;
+            via[next] = info[curr][e];
+            if (next == target) {
+              reached = true;
+              break;
+            }
+            work.push(next);
+          }
+        }
+        std::string segment;
+        unsigned int curr = target;
+        do {
+          segment.insert(segment.begin(), via[curr].first);
+          if (start == diag && parent[curr] == (int)start)
+            loc2 = trans[via[curr].second].loc;
+          curr = parent[curr];
+        } while (curr != start);
+        pump += segment;
+        start = target;
+      }
+
+      if (!find_string(initial, component[d], false, attack.prefix))
+        return false;
+      attack.pump = pump;
+      attack.loc2 = loc2;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool BacktrackChecker::find_polynomial(unsigned int p, unsigned int q,
+                                       unsigned long &budget,
+                                       BacktrackAttack &attack) {
+  std::string prefix;
+  std::string middle;
+  if (budget > 0)
+    budget--;
+  if (!find_string(p, q, false, middle) ||
+      !find_string(initial, p, false, prefix))
+    return false;
+
+  // search triples (x, y, z) where x loops on p, y moves from p to q, and z
+  // loops on q, all reading the same string
+  unsigned long n = num_states;
+  auto encode = [n](unsigned long x, unsigned long y, unsigned long z) {
+    return (x * n + y) * n + z;
+  };
+  unsigned long start = encode(p, p, q);
+  unsigned long goal = encode(p, q, q);
+
+  std::unordered_map<unsigned long, std::pair<unsigned long, char>> parent;
+  std::queue<unsigned long> work;
+  parent[start] = std::make_pair(start, '\0');
+  work.push(start);
+  while (!work.empty()) {
+    if (budget == 0) {
+      cut_offs++;
+      return false;
+    }
+    budget--;
+
+    unsigned long curr = work.front();
+    work.pop();
+    unsigned int x = curr / (n * n);
+    unsigned int y = (curr / n) % n;
+    unsigned int z = curr % n;
+
+    for (unsigned int i : out[x]) {
+      if (scc[trans[i].to] != scc[p])
+        continue;
+      for (unsigned int j : out[y]) {
+        CharLabel common = trans[i].label & trans[j].label;
+        if (common.none())
+          continue;
+        for (unsigned int l : out[z]) {
+          if (scc[trans[l].to] != scc[q])
+            continue;
+          CharLabel all = common & trans[l].label;
+          if (all.none())
+            continue;
+          unsigned long next = encode(trans[i].to, trans[j].to, trans[l].to);
+          if (parent.count(next))
+            continue;
+          parent[next] = std::make_pair(curr, pick_char(all));
+          if (next == goal) {
+            std::string pump;
+            for (unsigned long s = goal; s != start; s = parent[s].first)
+              pump.insert(pump.begin(), parent[s].second);
+            attack.exponential = false;
+            attack.loc1 = repeat_loc(p);
+            attack.loc2 = repeat_loc(q);
+            attack.prefix = prefix;
+            attack.pump = pump;
+            return true;
+          }
+          work.push(next);
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+bool BacktrackChecker::find_string(unsigned int from, unsigned int to,
+                                   bool within_scc, std::string &str) {
+  str = "";
+  if (from == to)
+    return true;
+
+  std::vector<int> parent(num_states, -1);
+  std::queue<unsigned int> work;
+  parent[from] = from;
+  work.push(from);
+  while (!work.empty()) {
+    unsigned int curr = work.front();
+    work.pop();
+    for (unsigned int i : out[curr]) {
+      unsigned int next = trans[i].to;
+      if (parent[next] != -1 || (within_scc && scc[next] != scc[from]))
+        continue;
+      parent[next] = i;
+      if (next == to) {
+        for (unsigned int s = to; s != from; s = trans[parent[s]].from)
+          str.insert(str.begin(), pick_char(trans[parent[s]].label));
+        return true;
+      }
+      work.push(next);
+    }
+  }
+  return false;
+}
+
+bool BacktrackChecker::reported(const std::vector<BacktrackAttack> &attacks,
+                                const BacktrackAttack &attack) {
+  // copies of an unrolled loop produce the same attack more than once
+  for (const BacktrackAttack &other : attacks) {
+    if (other.exponential == attack.exponential && other.loc1 == attack.loc1)
+      return true;
+  }
+  return false;
+}
+
+bool BacktrackChecker::find_char_string(unsigned int from, unsigned int to,
+                                        bool nonempty, std::string &str) {
+  // 0-1 breadth first search over (state, consumed a character) pairs where
+  // epsilon edges are free
+  const std::vector<std::vector<unsigned int>> &eps = automaton.get_epsilons();
+  const std::vector<CharAutomaton::Transition> &char_trans =
+      automaton.get_transitions();
+  const std::vector<std::vector<unsigned int>> &char_out =
+      automaton.get_transitions_out();
+
+  str = "";
+  unsigned int start = from * 2;
+  unsigned int goal = to * 2 + (nonempty ? 1 : 0);
+  std::vector<int> parent(num_states * 2, -1);
+  std::vector<int> via(num_states * 2, -1);
+  std::vector<unsigned int> dist(num_states * 2, ~0u);
+  std::deque<unsigned int> work;
+  dist[start] = 0;
+  work.push_back(start);
+  while (!work.empty()) {
+    unsigned int curr = work.front();
+    work.pop_front();
+    unsigned int state = curr / 2;
+    unsigned int consumed = curr % 2;
+    if (curr == goal || (!nonempty && curr == goal + 1))
+      break;
+
+    for (unsigned int next_state : eps[state]) {
+      unsigned int next = next_state * 2 + consumed;
+      if (dist[curr] < dist[next]) {
+        dist[next] = dist[curr];
+        parent[next] = curr;
+        via[next] = -1;
+        work.push_front(next);
+      }
+    }
+    for (unsigned int i : char_out[state]) {
+      unsigned int next = char_trans[i].to * 2 + 1;
+      if (dist[curr] + 1 < dist[next]) {
+        dist[next] = dist[curr] + 1;
+        parent[next] = curr;
+        via[next] = i;
+        work.push_back(next);
+      }
+    }
+  }
+
+  unsigned int end = goal;
+  if (!nonempty && dist[goal + 1] < dist[goal])
+    end = goal + 1;
+  if (dist[end] == ~0u)
+    return false;
+  for (unsigned int s = end; s != start; s = parent[s]) {
+    if (via[s] != -1)
+      str.insert(str.begin(), pick_char(char_trans[via[s]].label));
+  }
+  return true;
+}
+
+bool BacktrackChecker::find_suffix(BacktrackAttack &attack) {
+  // try the empty suffix, then characters not used by the regex, then the
+  // remaining characters
+  CharLabel used;
+  for (const Transition &t : trans)
+    used |= t.label;
+
+  std::vector<std::string> candidates;
+  candidates.push_back("");
+  CharLabel unused = ~used;
+  CharLabel remaining = used;
+  while (unused.any()) {
+    char c = pick_char(unused);
+    unused.reset((unsigned char)c);
+    candidates.push_back(std::string(1, c));
+  }
+  while (remaining.any()) {
+    char c = pick_char(remaining);
+    remaining.reset((unsigned char)c);
+    candidates.push_back(std::string(1, c));
+  }
+
+  for (const std::string &suffix : candidates) {
+    attack.suffix = suffix;
+    if (!accepts(attack.gen_attack_string(3)) &&
+        !accepts(attack.gen_attack_string(4)))
+      return true;
+  }
+  return false;
+}
+
+bool BacktrackChecker::accepts(const std::string &str) {
+  std::vector<bool> curr(num_states, false);
+  curr[initial] = true;
+  for (char c : str) {
+    std::vector<bool> next(num_states, false);
+    bool any = false;
+    for (unsigned int s = 0; s < num_states; s++) {
+      if (!curr[s])
+        continue;
+      for (unsigned int i : out[s]) {
+        if (trans[i].label.test((unsigned char)c)) {
+          next[trans[i].to] = true;
+          any = true;
+        }
+      }
+    }
+    if (!any)
+      return false;
+    curr.swap(next);
+  }
+  for (unsigned int s = 0; s < num_states; s++)
+    if (curr[s] && accepting[s])
+      return true;
+  return false;
+}
+
+Location BacktrackChecker::repeat_loc(unsigned int state) {
+  // the outermost repetition has the largest body
+  Location loc = std::make_pair(-1, -1);
+  unsigned int best = 0;
+  for (const CharAutomaton::BackEdge &back : automaton.get_back_edges()) {
+    if (char_scc[back.from] != char_scc[state] || back.body_size <= best)
+      continue;
+    best = back.body_size;
+    loc = back.loc;
+  }
+  return loc;
+}
+
+char BacktrackChecker::pick_char(const CharLabel &label) {
+  // prefer letters, digits, punctuation, and space before other characters
+  static const std::pair<int, int> ranges[] = {
+      {'a', 'z'}, {'A', 'Z'}, {'0', '9'}, {'!', '~'}, {' ', ' '}, {0, 255}};
+  for (const auto &range : ranges) {
+    for (int c = range.first; c <= range.second; c++)
+      if (label.test(c))
+        return (char)c;
+  }
+  return '\0';
+}
+
+std::vector<int>
+BacktrackChecker::find_sccs(const std::vector<std::vector<unsigned int>> &graph) {
+  // iterative version of Tarjan's algorithm
+  unsigned int n = graph.size();
+  std::vector<int> component(n, -1);
+  std::vector<int> index(n, -1);
+  std::vector<int> low(n, 0);
+  std::vector<bool> on_stack(n, false);
+  std::vector<unsigned int> stack;
+  std::vector<std::pair<unsigned int, unsigned int>> calls;
+  int counter = 0;
+  int num_components = 0;
+
+  for (unsigned int s = 0; s < n; s++) {
+    if (index[s] != -1)
+      continue;
+    index[s] = low[s] = counter++;
+    stack.push_back(s);
+    on_stack[s] = true;
+    calls.push_back(std::make_pair(s, 0));
+
+    while (!calls.empty()) {
+      unsigned int v = calls.back().first;
+      if (calls.back().second < graph[v].size()) {
+        unsigned int w = graph[v][calls.back().second++];
+        if (index[w] == -1) {
+          index[w] = low[w] = counter++;
+          stack.push_back(w);
+          on_stack[w] = true;
+          calls.push_back(std::make_pair(w, 0));
+        } else if (on_stack[w]) {
+          low[v] = std::min(low[v], index[w]);
+        }
+        continue;
+      }
+
+      if (low[v] == index[v]) {
+        unsigned int w;
+        do {
+          w = stack.back();
+          stack.pop_back();
+          on_stack[w] = false;
+          component[w] = num_components;
+        } while (w != v);
+        num_components++;
+      }
+      calls.pop_back();
+      if (!calls.empty()) {
+        unsigned int u = calls.back().first;
+        low[u] = std::min(low[u], low[v]);
+      }
+    }
+  }
+
+  return component;
+}
@@ -0,0 +1,130 @@
+/*  BacktrackChecker.h: detects catastrophic backtracking (ReDoS)
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BACKTRACK_CHECKER_H
+#define BACKTRACK_CHECKER_H
+
+#include "CharAutomaton.h"
+#include "NFA.h"
+#include "Util.h"
+#include <string>
+#include <vector>
+
+// Number of times the pump string is repeated in reported attack strings
+const unsigned int EXPONENTIAL_PUMPS = 20;
+const unsigned int POLYNOMIAL_PUMPS = 100;
+
+// An input that causes a backtracking matcher to take super-linear time.
+// The attack string is prefix + pump (repeated) + suffix.
+struct BacktrackAttack {
+  bool exponential;   // true for exponential, false for polynomial blowup
+  Location loc1;      // location of the repetition being pumped
+  Location loc2;      // location of the ambiguous element
+  std::string prefix; // string leading to the ambiguous repetition
+  std::string pump;   // string that can be matched in more than one way
+  std::string suffix; // string that forces the match to fail
+
+  // returns the attack string with the pump repeated the given times
+  std::string gen_attack_string(unsigned int pumps) const;
+};
+
+// Finds ambiguous repetitions in the character level automaton. A
+// repetition is exponentially ambiguous (EDA) if some string can take two
+// different paths from a state back to itself, and polynomially ambiguous
+// (IDA) if some string can loop on state p, move from p to q, and loop on
+// state q.
+class BacktrackChecker {
+
+public:
+  explicit BacktrackChecker(const NFA &nfa);
+
+  // returns a list of attacks, at most one per ambiguous repetition
+  std::vector<BacktrackAttack> find_attacks();
+
+  // returns one attack per repetition, using the ambiguous pump string when
+  // there is one and a single iteration of the repetition otherwise
+  std::vector<BacktrackAttack> gen_repeat_attacks();
+
+  // returns the number of searches cut off by the search limits, nonzero if
+  // find_attacks may have missed ambiguous repetitions
+  unsigned int get_cut_offs() const { return cut_offs; }
+
+private:
+  struct Transition {
+    unsigned int from;   // source state
+    unsigned int to;     // target state
+    CharLabel label;     // characters accepted by the transition
+    Location loc;        // location within original regex
+    unsigned int mult;   // number of distinct epsilon paths (max 2)
+  };
+
+  CharAutomaton automaton;                       // automaton being checked
+  unsigned int num_states;                       // character level states
+  unsigned int initial;                          // initial state
+  std::vector<int> char_scc;                     // SCC of each state
+
+  std::vector<Transition> trans;                 // epsilon free transitions
+  std::vector<std::vector<unsigned int>> out;    // transitions out of state
+  std::vector<bool> accepting;                   // states reaching final
+  std::vector<int> scc;                          // SCC (epsilon free)
+  unsigned int cut_offs;                         // searches cut off
+
+  // removes epsilon edges, keeping track of ambiguous epsilon paths
+  void remove_epsilons();
+
+  // checks one strongly connected component for exponential ambiguity
+  bool find_exponential(const std::vector<unsigned int> &component,
+                        BacktrackAttack &attack);
+
+  // checks a pair of states for polynomial ambiguity
+  bool find_polynomial(unsigned int p, unsigned int q, unsigned long &budget,
+                       BacktrackAttack &attack);
+
+  // finds a string leading from one state to another (within SCC if set)
+  bool find_string(unsigned int from, unsigned int to, bool within_scc,
+                   std::string &str);
+
+  // returns true if an attack for the same repetition was already found
+  static bool reported(const std::vector<BacktrackAttack> &attacks,
+                       const BacktrackAttack &attack);
+
+  // finds the shortest string on a character level path between two states
+  bool find_char_string(unsigned int from, unsigned int to, bool nonempty,
+                        std::string &str);
+
+  // finds a suffix causing prefix + pump + suffix to be rejected
+  bool find_suffix(BacktrackAttack &attack);
+
+  // returns true if the automaton accepts the string
+  bool accepts(const std::string &str);
+
+  // location of the outermost repetition containing the state
+  Location repeat_loc(unsigned int state);
+
+  // picks a readable character from a label
+  static char pick_char(const CharLabel &label);
+
+  // computes strongly connected components for a graph
+  static std::vector<int>
+  find_sccs(const std::vector<std::vector<unsigned int>> &graph);
+};
+
+#endif // BACKTRACK_CHECKER_H
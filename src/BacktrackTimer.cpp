@@ -0,0 +1,230 @@
+/*  BacktrackTimer.cpp: measures backtracking growth of attack strings
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BacktrackTimer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <regex>
+#include <sstream>
+
+// Limits on timing: the matcher recurses per character, so attack strings
+// are kept short, and a sample that takes too long ends the measurement
+static const unsigned int MAX_ATTACK_LENGTH = 2000;
+static const unsigned int MAX_SAMPLES = 24;
+static const double SAMPLE_LIMIT = 0.1;   // seconds
+static const double SLOW_SAMPLE = 0.001;  // seconds
+static const double MIN_DURATION = 0.001; // seconds per measurement
+static const double ATTACK_BUDGET = 1.0;  // seconds timing one repetition
+static const double RUN_BUDGET = 5.0;     // seconds timing all repetitions
+static const double FAST_RATE = 1.05;     // time growth per pump
+static const double MAX_DEGREE = 5;       // larger degrees are exponential
+static const double FIT_FRACTION = 0.05;  // of the slowest sample
+
+// seconds elapsed since the given time
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// the samples to fit as (pumps, log seconds): the slower samples where the
+// growth dominates fixed overhead, or all measured samples if too few of them
+// are slow
+static std::vector<std::pair<double, double>>
+fit_points(const std::vector<std::pair<unsigned int, double>> &samples) {
+  double max_time = 0;
+  for (auto &sample : samples)
+    max_time = std::max(max_time, sample.second);
+  std::vector<std::pair<double, double>> points;
+  for (auto &sample : samples) {
+    if (sample.second > 0 && sample.second >= max_time * FIT_FRACTION)
+      points.push_back(std::make_pair(sample.first, std::log(sample.second)));
+  }
+  if (points.size() < 3) {
+    points.clear();
+    for (auto &sample : samples) {
+      if (sample.second > 0)
+        points.push_back(
+            std::make_pair(sample.first, std::log(sample.second)));
+    }
+  }
+  return points;
+}
+
+// least squares fit of log seconds = a + b * x with x the pumps or their log,
+// returns <b, residual>
+static std::pair<double, double>
+fit_line(const std::vector<std::pair<double, double>> &points, bool log_x) {
+  double n = points.size(), sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (auto &p : points) {
+    double x = log_x ? std::log(p.first) : p.first;
+    sx += x;
+    sy += p.second;
+    sxx += x * x;
+    sxy += x * p.second;
+  }
+  double slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+  double intercept = (sy - slope * sx) / n;
+  double residual = 0;
+  for (auto &p : points) {
+    double x = log_x ? std::log(p.first) : p.first;
+    double diff = p.second - (intercept + slope * x);
+    residual += diff * diff;
+  }
+  return std::make_pair(slope, residual);
+}
+
+BacktrackTimer::BacktrackTimer(std::string r, const NFA &nfa,
+                               const std::map<int, Location> &repeat_spans) {
+  regex = std::move(r);
+  BacktrackChecker checker(nfa);
+  attacks = checker.gen_repeat_attacks();
+  for (const BacktrackAttack &attack : attacks) {
+    RepeatTiming timing;
+    timing.loc = attack.loc1;
+    auto it = repeat_spans.find(attack.loc1.first);
+    if (it != repeat_spans.end())
+      timing.loc = it->second;
+
+    // locations outside the regex are not shown
+    if (timing.loc.first < 0 || timing.loc.second < timing.loc.first ||
+        timing.loc.second >= (int)regex.size())
+      timing.loc = std::make_pair(-1, -1);
+    else
+      timing.subexpr = regex.substr(timing.loc.first,
+                                    timing.loc.second - timing.loc.first + 1);
+    timing.pump = attack.pump;
+    timing.exponential = attack.exponential;
+    timings.push_back(timing);
+  }
+}
+
+void BacktrackTimer::measure() {
+  std::regex re;
+  try {
+    re = std::regex(regex, std::regex::ECMAScript);
+  } catch (std::regex_error const &e) {
+    error = "std::regex does not support this regex";
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int i = 0; i < timings.size(); i++) {
+    double budget = std::min(ATTACK_BUDGET, RUN_BUDGET - seconds_since(start));
+    if (budget <= 0) {
+      timings[i].growth = "not timed, time budget used up";
+      continue;
+    }
+    measure_attack(re, attacks[i], budget, timings[i]);
+    timings[i].growth = fit_growth(timings[i].samples);
+  }
+}
+
+void BacktrackTimer::measure_attack(const std::regex &re,
+                                    const BacktrackAttack &attack,
+                                    double budget, RepeatTiming &timing) {
+  auto start = std::chrono::steady_clock::now();
+  unsigned int pumps = 1;
+  double max_rate = 0; // fastest time growth per pump
+  while (timing.samples.size() < MAX_SAMPLES) {
+    std::string str = attack.gen_attack_string(pumps);
+    if (str.length() > MAX_ATTACK_LENGTH)
+      break;
+
+    // repeat fast matches so the timer resolution does not matter
+    unsigned int reps = 0;
+    double elapsed = 0;
+    auto sample_start = std::chrono::steady_clock::now();
+    try {
+      do {
+        std::regex_match(str, re);
+        reps++;
+        elapsed = seconds_since(sample_start);
+      } while (elapsed < MIN_DURATION && reps < 1000);
+    } catch (std::regex_error const &e) {
+      break;
+    }
+    double seconds = elapsed / reps;
+    timing.samples.push_back(std::make_pair(pumps, seconds));
+    if (seconds > SAMPLE_LIMIT)
+      break;
+
+    // exponential attacks grow by one pump so a single step cannot hang,
+    // others double while matching is fast and grow slower after that
+    double rate = 0;
+    if (timing.samples.size() >= 2) {
+      auto prev = timing.samples[timing.samples.size() - 2];
+      if (prev.second > 0)
+        rate = std::pow(seconds / prev.second, 1.0 / (pumps - prev.first));
+    }
+    max_rate = std::max(max_rate, rate);
+    unsigned int next;
+    if (attack.exponential)
+      next = pumps + 1;
+    else if (seconds < SLOW_SAMPLE)
+      next = pumps * 2;
+    else if (rate > FAST_RATE)
+      next = pumps + 1;
+    else
+      next = pumps + (pumps + 1) / 2;
+
+    // stop before a sample that is expected to overrun the budget: growth
+    // of exponential attacks is predicted from the fastest rate seen so far
+    // since the rate varies between steps, other attacks from the power law
+    // fitted to the samples so far
+    double predicted;
+    if (attack.exponential) {
+      predicted = seconds * std::pow(std::max(max_rate, 1.0), next - pumps);
+    } else {
+      double degree = 1;
+      std::vector<std::pair<double, double>> points =
+          fit_points(timing.samples);
+      if (points.size() >= 2)
+        degree = std::max(degree, fit_line(points, true).first);
+      predicted = seconds * std::pow((double)next / pumps, degree);
+    }
+    if (seconds_since(start) + std::max(predicted, MIN_DURATION) > budget)
+      break;
+    pumps = next;
+  }
+}
+
+std::string BacktrackTimer::fit_growth(
+    const std::vector<std::pair<unsigned int, double>> &samples) {
+  std::vector<std::pair<double, double>> points = fit_points(samples);
+  if (points.size() < 3)
+    return "not enough samples";
+
+  auto poly = fit_line(points, true);
+  auto expo = fit_line(points, false);
+  std::stringstream s;
+  s << std::fixed << std::setprecision(2);
+  // over a narrow range of pumps both curves fit, so a very high degree
+  // also indicates exponential growth
+  if ((expo.second < poly.second || poly.first > MAX_DEGREE) &&
+      expo.first > std::log(1.1))
+    s << "exponential, x" << std::exp(expo.first) << " per pump";
+  else
+    s << "polynomial, degree " << poly.first;
+  return s.str();
+}
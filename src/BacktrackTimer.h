@@ -0,0 +1,72 @@
+/*  BacktrackTimer.h: measures backtracking growth of attack strings
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BACKTRACK_TIMER_H
+#define BACKTRACK_TIMER_H
+
+#include "BacktrackChecker.h"
+#include "NFA.h"
+#include "Util.h"
+#include <map>
+#include <regex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Times the attack string for each repetition against std::regex, a
+// backtracking matcher, and fits the measured times to a polynomial and an
+// exponential curve. A matcher call cannot be interrupted, so the pump count
+// grows in small steps and stops before a sample is expected to overrun the
+// time budget of the repetition or of the whole measurement.
+class BacktrackTimer {
+
+public:
+  // repeat_spans gives the repeated subexpression of each quantifier, as
+  // returned by ParseTree::get_repeat_spans
+  BacktrackTimer(std::string r, const NFA &nfa,
+                 const std::map<int, Location> &repeat_spans);
+
+  // time each repetition's attack string
+  void measure();
+
+  // get the timing results
+  const std::vector<RepeatTiming> &get_timings() const { return timings; }
+
+  // get the reason the repetitions could not be timed (empty if timed)
+  const std::string &get_error() const { return error; }
+
+  // fits the samples to a growth curve and describes it
+  static std::string fit_growth(
+      const std::vector<std::pair<unsigned int, double>> &samples);
+
+private:
+  std::string regex;                    // regular expression
+  std::string error;                    // set if std::regex rejects the regex
+  std::vector<BacktrackAttack> attacks; // attack of each repetition
+  std::vector<RepeatTiming> timings;    // timing results
+
+  // times one attack, stopping once the budget (in seconds) is used up
+  static void measure_attack(const std::regex &re,
+                             const BacktrackAttack &attack, double budget,
+                             RepeatTiming &timing);
+};
+
+#endif // BACKTRACK_TIMER_H
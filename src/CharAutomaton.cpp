@@ -0,0 +1,351 @@
+/*  CharAutomaton.cpp: character level automaton derived from the NFA
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CharAutomaton.h"
+#include "CharSet.h"
+#include "Edge.h"
+#include "RegexLoop.h"
+#include <algorithm>
+#include <map>
+#include <utility>
+
+// Bounded loops are unrolled until the automaton reaches this many states,
+// after that they are treated as unbounded
+static const unsigned int MAX_UNROLLED_STATES = 10000;
+
+CharAutomaton::CharAutomaton(const NFA &nfa) {
+  num_states = nfa.get_size();
+  initial = nfa.get_initial();
+  final = nfa.get_final();
+  exact = !nfa.has_ignored_elements();
+  eps.assign(num_states, std::vector<unsigned int>());
+  trans_out.assign(num_states, std::vector<unsigned int>());
+
+  std::map<RegexLoop *, unsigned int> loop_index;
+  std::vector<unsigned int> carets;  // sources of ^ edges
+  std::vector<unsigned int> dollars; // targets of $ edges
+  for (unsigned int from = 0; from < nfa.get_size(); from++) {
+    for (const auto &target : nfa.get_edges(from)) {
+      unsigned int to = target.first;
+      std::shared_ptr<Edge> edge = target.second;
+
+      Transition t;
+      t.from = from;
+      t.to = to;
+      t.loc = edge->get_loc();
+
+      switch (edge->get_type()) {
+      case CHARACTER_EDGE:
+        t.label.set((unsigned char)edge->get_character());
+        trans_out[from].push_back(trans.size());
+        trans.push_back(t);
+        break;
+
+      case CHAR_SET_EDGE: {
+        std::shared_ptr<CharSet> char_set = edge->get_charset();
+        if (char_set->has_approximate_class())
+          exact = false;
+        for (unsigned int c = 0; c < 256; c++)
+          if (char_set->is_valid_character((char)c))
+            t.label.set(c);
+        trans_out[from].push_back(trans.size());
+        trans.push_back(t);
+        break;
+      }
+
+      case STRING_EDGE: {
+        // x+ becomes from -x-> aux, aux -x-> aux, aux -> to
+        std::shared_ptr<CharSet> char_set = edge->get_charset();
+        if (char_set->has_approximate_class())
+          exact = false;
+        for (unsigned int c = 0; c < 256; c++)
+          if (char_set->is_valid_character((char)c))
+            t.label.set(c);
+        unsigned int aux = add_state();
+        t.to = aux;
+        trans_out[from].push_back(trans.size());
+        trans.push_back(t);
+        t.from = aux;
+        trans_out[aux].push_back(trans.size());
+        trans.push_back(t);
+        back_edges.push_back({aux, aux, t.loc, 1});
+        eps[aux].push_back(to);
+        if (edge->get_repeat_lower_limit() == 0)
+          eps[from].push_back(to);
+        break;
+      }
+
+      case BEGIN_LOOP_EDGE:
+      case END_LOOP_EDGE: {
+        RegexLoop *regex_loop = edge->get_regex_loop().get();
+        auto it = loop_index.find(regex_loop);
+        if (it == loop_index.end()) {
+          Loop loop;
+          loop.lower = regex_loop->get_repeat_lower();
+          loop.upper = regex_loop->get_repeat_upper();
+          loop.done = false;
+          it = loop_index.insert(std::make_pair(regex_loop, loops.size())).first;
+          loops.push_back(loop);
+        }
+        Loop &loop = loops[it->second];
+        if (edge->get_type() == BEGIN_LOOP_EDGE) {
+          loop.begin_from = from;
+          loop.begin_to = to;
+          loop.loc = edge->get_loc();
+        } else {
+          loop.end_from = from;
+          loop.end_to = to;
+        }
+        break;
+      }
+
+      case BACKREFERENCE_EDGE:
+        exact = false;
+        eps[from].push_back(to);
+        break;
+
+      case CARET_EDGE:
+        carets.push_back(from);
+        eps[from].push_back(to);
+        break;
+
+      case DOLLAR_EDGE:
+        dollars.push_back(to);
+        eps[from].push_back(to);
+        break;
+
+      default:
+        eps[from].push_back(to);
+        break;
+      }
+    }
+  }
+
+  check_anchors(nfa, carets, dollars);
+
+  loop_out.assign(num_states, std::vector<unsigned int>());
+  for (unsigned int i = 0; i < loops.size(); i++) {
+    loop_out[loops[i].begin_from].push_back(i);
+    loop_out[loops[i].end_from].push_back(i);
+  }
+
+  // unroll inner loops first so that outer loops copy the unrolled bodies
+  std::vector<std::pair<unsigned int, unsigned int>> order;
+  for (unsigned int i = 0; i < loops.size(); i++)
+    order.push_back(std::make_pair(find_body(loops[i]).size(), i));
+  std::sort(order.begin(), order.end());
+  for (auto &entry : order)
+    unroll(loops[entry.second]);
+}
+
+// The anchors are epsilon edges, which only describes the regex when no
+// character can be matched before a ^ or after a $. Repeated loop bodies are
+// followed through their end edge back to the start of the body.
+void CharAutomaton::check_anchors(const NFA &nfa,
+                                  const std::vector<unsigned int> &carets,
+                                  const std::vector<unsigned int> &dollars) {
+  if (carets.empty() && dollars.empty())
+    return;
+
+  unsigned int size = nfa.get_size();
+  std::vector<std::vector<unsigned int>> succ(size), pred(size);
+  std::vector<bool> after_char(size, false);  // reached after a character
+  std::vector<bool> before_char(size, false); // reaches a character
+  std::vector<unsigned int> after_work, before_work;
+  for (unsigned int from = 0; from < size; from++) {
+    for (const auto &target : nfa.get_edges(from)) {
+      unsigned int to = target.first;
+      succ[from].push_back(to);
+      pred[to].push_back(from);
+      switch (target.second->get_type()) {
+      case CHARACTER_EDGE:
+      case CHAR_SET_EDGE:
+      case STRING_EDGE:
+      case BACKREFERENCE_EDGE:
+        if (!after_char[to]) {
+          after_char[to] = true;
+          after_work.push_back(to);
+        }
+        if (!before_char[from]) {
+          before_char[from] = true;
+          before_work.push_back(from);
+        }
+        break;
+      default:
+        break;
+      }
+    }
+  }
+  for (const Loop &loop : loops) {
+    if (loop.upper != 0 && loop.upper != 1) {
+      succ[loop.end_from].push_back(loop.begin_to);
+      pred[loop.begin_to].push_back(loop.end_from);
+    }
+  }
+
+  auto propagate = [](std::vector<bool> &reached,
+                      std::vector<unsigned int> &work,
+                      const std::vector<std::vector<unsigned int>> &next) {
+    while (!work.empty()) {
+      unsigned int state = work.back();
+      work.pop_back();
+      for (unsigned int n : next[state]) {
+        if (!reached[n]) {
+          reached[n] = true;
+          work.push_back(n);
+        }
+      }
+    }
+  };
+  propagate(after_char, after_work, succ);
+  propagate(before_char, before_work, pred);
+
+  for (unsigned int state : carets)
+    if (after_char[state])
+      exact = false;
+  for (unsigned int state : dollars)
+    if (before_char[state])
+      exact = false;
+}
+
+unsigned int CharAutomaton::add_state() {
+  eps.emplace_back();
+  trans_out.emplace_back();
+  return num_states++;
+}
+
+std::vector<unsigned int> CharAutomaton::find_body(const Loop &loop) {
+  std::vector<bool> seen(num_states, false);
+  std::vector<unsigned int> body;
+  std::vector<unsigned int> work(1, loop.begin_to);
+  seen[loop.begin_to] = true;
+
+  auto visit = [&seen, &work](unsigned int state) {
+    if (!seen[state]) {
+      seen[state] = true;
+      work.push_back(state);
+    }
+  };
+
+  while (!work.empty()) {
+    unsigned int state = work.back();
+    work.pop_back();
+    body.push_back(state);
+    for (unsigned int next : eps[state])
+      visit(next);
+    for (unsigned int i : trans_out[state])
+      visit(trans[i].to);
+
+    // loop edges that have not been replaced yet
+    if (state >= loop_out.size())
+      continue;
+    for (unsigned int i : loop_out[state]) {
+      const Loop &other = loops[i];
+      if (other.done)
+        continue;
+      if (other.begin_from == state)
+        visit(other.begin_to);
+      if (other.end_from == state && &other != &loop)
+        visit(other.end_to);
+    }
+  }
+
+  std::sort(body.begin(), body.end());
+  return body;
+}
+
+void CharAutomaton::unroll(Loop &loop) {
+  std::vector<unsigned int> body = find_body(loop);
+
+  // number of copies of the body, the last one repeats if unbounded
+  unsigned int copies;
+  if (loop.upper == -1)
+    copies = std::max(loop.lower, 1);
+  else
+    copies = loop.upper;
+  if (copies > 1 &&
+      num_states + (copies - 1) * body.size() > MAX_UNROLLED_STATES) {
+    exact = false;
+    loop.lower = std::min(loop.lower, 1);
+    loop.upper = -1;
+    copies = 1;
+  }
+
+  std::vector<unsigned int> entries;
+  std::vector<unsigned int> exits;
+  if (copies > 0) {
+    entries.push_back(loop.begin_to);
+    exits.push_back(loop.end_from);
+  }
+
+  unsigned int num_back_edges = back_edges.size();
+  for (unsigned int k = 1; k < copies; k++) {
+    std::map<unsigned int, unsigned int> copy;
+    for (unsigned int state : body)
+      copy[state] = add_state();
+
+    for (unsigned int state : body) {
+      unsigned int copy_state = copy[state];
+      for (unsigned int next : eps[state])
+        eps[copy_state].push_back(copy[next]);
+      for (unsigned int i : trans_out[state]) {
+        Transition t = trans[i];
+        t.from = copy_state;
+        t.to = copy[t.to];
+        trans_out[copy_state].push_back(trans.size());
+        trans.push_back(t);
+      }
+    }
+    for (unsigned int i = 0; i < num_back_edges; i++) {
+      BackEdge back = back_edges[i];
+      if (!std::binary_search(body.begin(), body.end(), back.from))
+        continue;
+      back.from = copy[back.from];
+      back.to = copy[back.to];
+      back_edges.push_back(back);
+    }
+
+    entries.push_back(copy[loop.begin_to]);
+    exits.push_back(copy[loop.end_from]);
+  }
+
+  // connect the copies in sequence, leaving after the minimum number
+  if (copies == 0) {
+    eps[loop.begin_from].push_back(loop.end_to);
+  } else {
+    eps[loop.begin_from].push_back(entries[0]);
+    for (unsigned int k = 0; k + 1 < copies; k++) {
+      eps[exits[k]].push_back(entries[k + 1]);
+      if ((int)k + 1 >= loop.lower)
+        eps[exits[k]].push_back(loop.end_to);
+    }
+    eps[exits[copies - 1]].push_back(loop.end_to);
+    if (loop.lower == 0)
+      eps[loop.begin_from].push_back(loop.end_to);
+    if (loop.upper == -1) {
+      eps[exits[copies - 1]].push_back(entries[copies - 1]);
+      back_edges.push_back({exits[copies - 1], entries[copies - 1], loop.loc,
+                            (unsigned int)body.size()});
+    }
+  }
+
+  loop.done = true;
+}
@@ -0,0 +1,113 @@
+/*  CharAutomaton.h: character level automaton derived from the NFA
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHAR_AUTOMATON_H
+#define CHAR_AUTOMATON_H
+
+#include "NFA.h"
+#include "Util.h"
+#include <bitset>
+#include <vector>
+
+// Set of characters accepted by a transition
+typedef std::bitset<256> CharLabel;
+
+// The EGRET NFA visits each loop body once and describes repetition with
+// loop edges. This automaton describes the language instead: strings are
+// expanded into self loops, bounded loops are unrolled, and unbounded loops
+// get back edges. Anchors, backreferences and ignored elements become epsilon
+// edges.
+class CharAutomaton {
+
+public:
+  struct Transition {
+    unsigned int from; // source state
+    unsigned int to;   // target state
+    CharLabel label;   // characters accepted by the transition
+    Location loc;      // location within original regex
+  };
+
+  struct BackEdge {
+    unsigned int from;      // end of repeated segment
+    unsigned int to;        // start of repeated segment
+    Location loc;           // location of the repetition
+    unsigned int body_size; // number of states in repeated segment
+  };
+
+  explicit CharAutomaton(const NFA &nfa);
+
+  // accessors
+  unsigned int get_num_states() const { return num_states; }
+  unsigned int get_initial() const { return initial; }
+  unsigned int get_final() const { return final; }
+  const std::vector<std::vector<unsigned int>> &get_epsilons() const {
+    return eps;
+  }
+  const std::vector<Transition> &get_transitions() const { return trans; }
+  const std::vector<std::vector<unsigned int>> &get_transitions_out() const {
+    return trans_out;
+  }
+  const std::vector<BackEdge> &get_back_edges() const { return back_edges; }
+
+  // returns false if the automaton only approximates the regex (due to
+  // backreferences, anchors inside the regex, ignored elements such as \b,
+  // approximated classes or loops too large to unroll)
+  bool is_exact() const { return exact; }
+
+private:
+  struct Loop {
+    unsigned int begin_from; // source of BEGIN_LOOP edge
+    unsigned int begin_to;   // target of BEGIN_LOOP edge
+    unsigned int end_from;   // source of END_LOOP edge
+    unsigned int end_to;     // target of END_LOOP edge
+    int lower;               // lower bound for repeat
+    int upper;               // upper bound for repeat (-1 if no bound)
+    Location loc;            // location of the repeat quantifier
+    bool done;               // set once the loop is unrolled
+  };
+
+  unsigned int num_states;                          // number of states
+  unsigned int initial;                             // initial state
+  unsigned int final;                               // final state
+  std::vector<std::vector<unsigned int>> eps;       // epsilon edges
+  std::vector<Transition> trans;                    // character edges
+  std::vector<std::vector<unsigned int>> trans_out; // edges out of state
+  std::vector<BackEdge> back_edges;                 // repetition back edges
+  std::vector<Loop> loops;                          // loops to unroll
+  std::vector<std::vector<unsigned int>> loop_out;  // loops with edge out
+  bool exact;                                       // set if not approximate
+
+  // clears exact if a character can be matched before a ^ (given by its
+  // source) or after a $ (given by its target)
+  void check_anchors(const NFA &nfa, const std::vector<unsigned int> &carets,
+                     const std::vector<unsigned int> &dollars);
+
+  // adds a new state
+  unsigned int add_state();
+
+  // finds the states in a loop body, stopping at the loop's end edge
+  std::vector<unsigned int> find_body(const Loop &loop);
+
+  // replaces a loop with copies of its body
+  void unroll(Loop &loop);
+};
+
+#endif // CHAR_AUTOMATON_H
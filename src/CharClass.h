@@ -0,0 +1,147 @@
+/*  CharClass.h: compile time character classification tables
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CHAR_CLASS_H
+#define CHAR_CLASS_H
+
+// Character flags (matching the C locale ctype functions)
+const unsigned int CHAR_LOWER = 1 << 0; // a-z
+const unsigned int CHAR_UPPER = 1 << 1; // A-Z
+const unsigned int CHAR_DIGIT = 1 << 2; // 0-9
+const unsigned int CHAR_PUNCT = 1 << 3; // ispunct
+const unsigned int CHAR_SPACE = 1 << 4; // isspace
+
+// Membership in the character classes of a character set (\s only matches
+// a space)
+const unsigned int CLASS_WORD = 1 << 5;      // \w
+const unsigned int CLASS_NOT_WORD = 1 << 6;  // \W
+const unsigned int CLASS_DIGIT = 1 << 7;     // \d
+const unsigned int CLASS_NOT_DIGIT = 1 << 8; // \D
+const unsigned int CLASS_SPACE = 1 << 9;     // \s
+const unsigned int CLASS_NOT_SPACE = 1 << 10; // \S
+const unsigned int CLASS_ANY = 1 << 11;      // .
+
+// Characters with a meaning to the scanner (all others are literals)
+const unsigned int CHAR_SPECIAL = 1 << 12;
+
+// Punctuation marks in the order used when picking a valid character
+constexpr char PUNC_CHARS[32] = {'!', '\"', '#', '$', '%', '&', '\'', '*',
+                                 '+', '/',  ':', ';', '<', '=', '>',  '?',
+                                 '@', '\\', '^', '_', '`', '~', '-',  '.',
+                                 '{', '[',  '(', '}', ']', ')', ',',  '|'};
+
+// 256 entry table of flags, indexed by unsigned char
+struct CharFlagTable {
+  unsigned int flags[256];
+};
+
+namespace char_class_detail {
+
+constexpr bool is_lower(unsigned int c) { return c >= 'a' && c <= 'z'; }
+constexpr bool is_upper(unsigned int c) { return c >= 'A' && c <= 'Z'; }
+constexpr bool is_digit(unsigned int c) { return c >= '0' && c <= '9'; }
+constexpr bool is_word(unsigned int c) {
+  return is_lower(c) || is_upper(c) || is_digit(c) || c == '_';
+}
+constexpr bool is_punct(unsigned int c) {
+  return (c >= '!' && c <= '/') || (c >= ':' && c <= '@') ||
+         (c >= '[' && c <= '`') || (c >= '{' && c <= '~');
+}
+constexpr bool is_space(unsigned int c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+constexpr bool is_special(unsigned int c) {
+  return c == '\\' || c == '[' || c == ']' || c == '-' || c == '|' ||
+         c == '*' || c == '+' || c == '?' || c == '(' || c == ')' ||
+         c == '.' || c == '{' || c == '^' || c == '$';
+}
+
+constexpr unsigned int char_flags(unsigned int c) {
+  return (is_lower(c) ? CHAR_LOWER : 0) | (is_upper(c) ? CHAR_UPPER : 0) |
+         (is_digit(c) ? CHAR_DIGIT : 0) | (is_punct(c) ? CHAR_PUNCT : 0) |
+         (is_space(c) ? CHAR_SPACE : 0) | (is_special(c) ? CHAR_SPECIAL : 0) |
+         (is_word(c) ? CLASS_WORD : CLASS_NOT_WORD) |
+         (is_digit(c) ? CLASS_DIGIT : CLASS_NOT_DIGIT) |
+         (c == ' ' ? CLASS_SPACE : CLASS_NOT_SPACE) | CLASS_ANY;
+}
+
+constexpr unsigned int class_item_flag(unsigned int c) {
+  return c == 'w'   ? CLASS_WORD
+         : c == 'W' ? CLASS_NOT_WORD
+         : c == 'd' ? CLASS_DIGIT
+         : c == 'D' ? CLASS_NOT_DIGIT
+         : c == 's' ? CLASS_SPACE
+         : c == 'S' ? CLASS_NOT_SPACE
+         : c == '.' ? CLASS_ANY
+                    : 0;
+}
+
+// builds a table from the indices 0-255 (std::index_sequence is C++14)
+template <unsigned int... Is> struct Indices {};
+template <unsigned int N, unsigned int... Is>
+struct MakeIndices : MakeIndices<N - 1, N - 1, Is...> {};
+template <unsigned int... Is> struct MakeIndices<0, Is...> {
+  typedef Indices<Is...> type;
+};
+
+template <unsigned int... Is>
+constexpr CharFlagTable make_char_table(Indices<Is...>) {
+  return CharFlagTable{{char_flags(Is)...}};
+}
+
+template <unsigned int... Is>
+constexpr CharFlagTable make_class_table(Indices<Is...>) {
+  return CharFlagTable{{class_item_flag(Is)...}};
+}
+
+} // namespace char_class_detail
+
+// Flags of each character
+constexpr CharFlagTable CHAR_FLAGS = char_class_detail::make_char_table(
+    char_class_detail::MakeIndices<256>::type());
+
+// Class flag for the letter of each character class item (0 if not a class)
+constexpr CharFlagTable CLASS_ITEM_FLAGS = char_class_detail::make_class_table(
+    char_class_detail::MakeIndices<256>::type());
+
+// returns true if the character has any of the given flags
+inline bool char_has_flag(char c, unsigned int flags) {
+  return (CHAR_FLAGS.flags[(unsigned char)c] & flags) != 0;
+}
+
+inline bool is_punct_char(char c) { return char_has_flag(c, CHAR_PUNCT); }
+inline bool is_space_char(char c) { return char_has_flag(c, CHAR_SPACE); }
+inline bool is_lower_char(char c) { return char_has_flag(c, CHAR_LOWER); }
+inline bool is_upper_char(char c) { return char_has_flag(c, CHAR_UPPER); }
+inline bool is_digit_char(char c) { return char_has_flag(c, CHAR_DIGIT); }
+inline bool is_special_char(char c) { return char_has_flag(c, CHAR_SPECIAL); }
+
+// returns the class flag for a character class item (0 if invalid)
+inline unsigned int class_item_flag(char cls) {
+  return CLASS_ITEM_FLAGS.flags[(unsigned char)cls];
+}
+
+// returns true if the character is in the character class \cls
+inline bool in_char_class(char cls, char c) {
+  return char_has_flag(c, class_item_flag(cls));
+}
+
+#endif // CHAR_CLASS_H
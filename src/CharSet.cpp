@@ -20,6 +20,7 @@
 */
 
 #include "CharSet.h"
+#include "CharClass.h"
 #include "Path.h"
 #include "Util.h"
 #include <algorithm>
@@ -29,8 +30,132 @@
 #include <string>
 #include <vector>
 
+// CHARACTER SET POOL
+
+std::shared_ptr<CharSetCache>
+CharSetPool::intern(const std::string &key,
+                    const std::shared_ptr<CharSetCache> &cache) {
+  auto it = caches.find(key);
+  if (it != caches.end()) {
+    num_shared++;
+    return it->second;
+  }
+  caches[key] = cache;
+  return cache;
+}
+
+void CharSetPool::partition_alphabet(const std::set<char> &chars) {
+  // refine the partition by each set and each character
+  std::vector<std::bitset<256>> splits;
+  for (auto &entry : caches)
+    splits.push_back(entry.second->members);
+  for (char c : chars) {
+    std::bitset<256> single;
+    single.set((unsigned char)c);
+    splits.push_back(single);
+  }
+
+  auto alphabet = std::make_shared<std::vector<unsigned int>>(256, 0);
+  num_classes = 1;
+  for (const std::bitset<256> &split : splits) {
+    std::map<std::pair<unsigned int, bool>, unsigned int> classes;
+    for (unsigned int c = 0; c < 256; c++) {
+      auto key = std::make_pair((*alphabet)[c], (bool)split.test(c));
+      auto it = classes.find(key);
+      if (it == classes.end())
+        it = classes.insert(std::make_pair(key, classes.size())).first;
+      (*alphabet)[c] = it->second;
+    }
+    num_classes = classes.size();
+  }
+
+  for (auto &entry : caches) {
+    entry.second->alphabet = alphabet;
+    entry.second->has_test_chars = false;
+  }
+}
+
 // CONSTRUCTION FUNCTIONS
-void CharSet::add_item(CharSetItem item) { items.push_back(item); }
+
+void CharSet::add_item(CharSetItem item) {
+  std::bitset<256> item_members;
+  switch (item.type) {
+  case CHARACTER_ITEM:
+    item_members.set((unsigned char)item.character);
+    break;
+  case CHAR_CLASS_ITEM: {
+    unsigned int flag = class_item_flag(item.character);
+    if (flag == 0) {
+      std::stringstream s;
+      s << "ERROR (internal): Invalid character class in character set: "
+        << item.character;
+      throw EgretException(s.str());
+    }
+    for (unsigned int c = 0; c < 256; c++)
+      if (char_has_flag((char)c, flag))
+        item_members.set(c);
+    break;
+  }
+  case CHAR_RANGE_ITEM:
+    for (int c = item.range_start; c <= item.range_end; c++)
+      item_members.set((unsigned char)c);
+    break;
+  }
+
+  own_cache();
+  if (complement)
+    cache->members &= ~item_members;
+  else
+    cache->members |= item_members;
+  items.push_back(item);
+}
+
+void CharSet::set_complement(bool c) {
+  if (c != complement) {
+    own_cache();
+    cache->members.flip();
+  }
+  complement = c;
+}
+
+void CharSet::set_alternation(bool a) {
+  if (a != alternation)
+    own_cache();
+  alternation = a;
+}
+
+void CharSet::intern(CharSetPool &pool) {
+  cache = pool.intern(get_key(), cache);
+}
+
+void CharSet::own_cache() {
+  if (cache.use_count() > 1)
+    cache = std::make_shared<CharSetCache>(*cache);
+  cache->has_test_chars = false;
+  cache->alphabet.reset();
+}
+
+std::string CharSet::get_key() const {
+  std::string key(1, complement ? '^' : (alternation ? '|' : '['));
+  for (const CharSetItem &item : items) {
+    switch (item.type) {
+    case CHARACTER_ITEM:
+      key += 'c';
+      key += item.character;
+      break;
+    case CHAR_CLASS_ITEM:
+      key += 'k';
+      key += item.character;
+      break;
+    case CHAR_RANGE_ITEM:
+      key += 'r';
+      key += item.range_start;
+      key += item.range_end;
+      break;
+    }
+  }
+  return key;
+}
 
 // PROPERTY FUNCTIONS
 
@@ -45,6 +170,16 @@ bool CharSet::is_wildcard() {
   return (item_ptr->type == CHAR_CLASS_ITEM && item_ptr->character == '.');
 }
 
+bool CharSet::has_approximate_class() {
+  for (const CharSetItem &item : items) {
+    if (item.type == CHAR_CLASS_ITEM &&
+        (item.character == 's' || item.character == 'S' ||
+         item.character == '.'))
+      return true;
+  }
+  return false;
+}
+
 bool CharSet::is_string_candidate() {
   // In for order a char set to be a string candidate, one of the
   // following must be true:
@@ -64,21 +199,9 @@ bool CharSet::is_string_candidate() {
     case CHARACTER_ITEM:
       break; // Ignore
     case CHAR_CLASS_ITEM:
-      switch (it->character) {
-#if 0
-          case 'w':	candidate = true; break;
-          case 'D':	candidate = true; break;
-          case 'S':	candidate = true; break;
-          case '.':	candidate = true; break;
-#endif
-      case 'w':
-      case 'D':
-      case 'S':
-      case '.':
+      // classes with letters: \w, \D, \S, or .
+      if (in_char_class(it->character, 'a'))
         candidate = true;
-        break;
-      default:;
-      }
       break;
     case CHAR_RANGE_ITEM:
       if (it->range_start == 'a' && it->range_end == 'z') {
@@ -107,18 +230,13 @@ bool CharSet::allows_punctuation() {
   for (it = items.begin(); it != items.end(); it++) {
     switch (it->type) {
     case CHARACTER_ITEM:
-      if (ispunct(it->character))
+      if (is_punct_char(it->character))
         return true;
       break;
     case CHAR_CLASS_ITEM:
-      switch (it->character) {
-      case 'E':
-      case 'D':
-      case 'S':
-      case '.':
+      if (class_item_flag(it->character) &
+          (CLASS_NOT_DIGIT | CLASS_NOT_SPACE | CLASS_ANY))
         return true;
-      default:;
-      }
       break;
     case CHAR_RANGE_ITEM:
       break; // ignore
@@ -141,13 +259,13 @@ bool CharSet::only_has_punc(bool allow_spaces) {
     case CHARACTER_ITEM: {
       char c = it->character;
       if (allow_spaces) {
-        if (!isspace(c) && !ispunct(c))
+        if (!is_space_char(c) && !is_punct_char(c))
           return false;
       } else {
-        if (!ispunct(c))
+        if (!is_punct_char(c))
           return false;
       }
-      if (ispunct(c))
+      if (is_punct_char(c))
         found_punc = true;
       break;
     }
@@ -156,13 +274,13 @@ bool CharSet::only_has_punc(bool allow_spaces) {
       char end = it->range_end;
       for (char c = start; c <= end; c++) {
         if (allow_spaces) {
-          if (!isspace(c) && !ispunct(c))
+          if (!is_space_char(c) && !is_punct_char(c))
             return false;
         } else {
-          if (!ispunct(c))
+          if (!is_punct_char(c))
             return false;
         }
-        if (ispunct(c))
+        if (is_punct_char(c))
           found_punc = true;
       }
       break;
@@ -187,72 +305,7 @@ bool CharSet::only_has_punc(bool allow_spaces) {
 }
 
 bool CharSet::is_valid_character(char character) {
-  for (auto &item : items) {
-    switch (item.type) {
-    case CHARACTER_ITEM:
-      if (character == item.character)
-        return !complement;
-      break;
-    case CHAR_CLASS_ITEM:
-      switch (item.character) {
-      case 'w':
-        if (character >= 'a' && character <= 'z')
-          return !complement;
-        if (character >= 'A' && character <= 'Z')
-          return !complement;
-        if (character >= '0' && character <= '9')
-          return !complement;
-        if (character == '_')
-          return !complement;
-        break;
-      case 'd':
-        if (character >= '0' && character <= '9')
-          return !complement;
-        break;
-      case 's':
-        if (character == ' ')
-          return !complement;
-        break;
-      case 'W': {
-        bool matches_w = false;
-        if (character >= 'a' && character <= 'z')
-          matches_w = true;
-        if (character >= 'A' && character <= 'Z')
-          matches_w = true;
-        if (character >= '0' && character <= '9')
-          matches_w = true;
-        if (character == '_')
-          matches_w = true;
-        if (!matches_w)
-          return !complement;
-        break;
-      }
-      case 'D':
-        if (!(character >= '0' && character <= '9'))
-          return !complement;
-        break;
-      case 'S':
-        if (character != ' ')
-          return !complement;
-        break;
-      case '.':
-        return !complement;
-      default: {
-        std::stringstream s;
-        s << "ERROR (internal): Invalid character class in character set: "
-          << item.character;
-        throw EgretException(s.str());
-      }
-      }
-      break;
-
-    case CHAR_RANGE_ITEM:
-      if (character >= item.range_start && character <= item.range_end)
-        return !complement;
-      break;
-    }
-  }
-  return complement;
+  return cache->members.test((unsigned char)character);
 }
 
 bool CharSet::has_character_item(char character) {
@@ -290,10 +343,6 @@ std::string CharSet::get_charset_as_string() {
 
 char CharSet::get_valid_character(char except) {
   std::vector<CharSetItem>::iterator it;
-  const char PUNC_ARRAY[32] = {'!', '\"', '#', '$', '%', '&', '\'', '*',
-                               '+', '/',  ':', ';', '<', '=', '>',  '?',
-                               '@', '\\', '^', '_', '`', '~', '-',  '.',
-                               '{', '[',  '(', '}', ']', ')', ',',  '|'};
 
   if (Util::get()->is_check_mode()) {
     // TODO: The first of the function for test generation could be skipped over
@@ -316,7 +365,7 @@ char CharSet::get_valid_character(char except) {
       if (is_valid_character(c))
         return c;
     }
-    for (char c : PUNC_ARRAY) {
+    for (char c : PUNC_CHARS) {
       if (except == c)
         continue;
       if (is_valid_character(c))
@@ -501,7 +550,7 @@ void CharSet::check(Path *path, Location loc) {
         ind_chars.insert(c);
       }
 
-      if (ispunct(c)) {
+      if (is_punct_char(c)) {
         if (c == '|') {
           if (it != items.begin() && it + 1 != items.end()) {
             bar_found = true;
@@ -620,43 +669,41 @@ void CharSet::check(Path *path, Location loc) {
     }
   }
 
-  // Report brace violations
+  // Report brace violations - they share a location so only the first one
+  // would be kept
+  if (!Util::get()->is_new_alert("charset brace", loc))
+    return;
   if (is_valid_character('(') && !is_valid_character(')')) {
     Alert a("charset brace",
             "Found ( in charset but not ), could lead to unbalanced ()", loc);
     a.has_example = true;
     a.example = path->gen_example_string(loc, '(', ')');
     Util::get()->add_alert(a);
-  }
-  if (is_valid_character('{') && !is_valid_character('}')) {
+  } else if (is_valid_character('{') && !is_valid_character('}')) {
     Alert a("charset brace",
             "Found { in charset but not {, could lead to unbalanced {}", loc);
     a.has_example = true;
     a.example = path->gen_example_string(loc, '{', '}');
     Util::get()->add_alert(a);
-  }
-  if (is_valid_character('[') && !is_valid_character(']')) {
+  } else if (is_valid_character('[') && !is_valid_character(']')) {
     Alert a("charset brace",
             "Found [ in charset but not ], could lead to unbalanced []", loc);
     a.has_example = true;
     a.example = path->gen_example_string(loc, '[', ']');
     Util::get()->add_alert(a);
-  }
-  if (!is_valid_character('(') && is_valid_character(')')) {
+  } else if (!is_valid_character('(') && is_valid_character(')')) {
     Alert a("charset brace",
             "Found ) in charset but not (, could lead to unbalanced ()", loc);
     a.has_example = true;
     a.example = path->gen_example_string(loc, ')', '(');
     Util::get()->add_alert(a);
-  }
-  if (!is_valid_character('{') && is_valid_character('}')) {
+  } else if (!is_valid_character('{') && is_valid_character('}')) {
     Alert a("charset brace",
             "Found } in charset but not {, could lead to unbalanced {}", loc);
     a.has_example = true;
     a.example = path->gen_example_string(loc, '}', '{');
     Util::get()->add_alert(a);
-  }
-  if (!is_valid_character('[') && is_valid_character(']')) {
+  } else if (!is_valid_character('[') && is_valid_character(']')) {
     Alert a("charset brace",
             "Found ] in charset but not [, could lead to unbalanced []", loc);
     a.has_example = true;
@@ -722,13 +769,8 @@ bool CharSet::has_upper_range() {
     case CHARACTER_ITEM:
       break;
     case CHAR_CLASS_ITEM:
-      switch (it->character) {
-      case 'w':
-      case 'D':
-      case 'S':
-      case '.':
+      if (in_char_class(it->character, 'A'))
         return true;
-      }
       break;
     case CHAR_RANGE_ITEM:
       if (it->range_start == 'A' && it->range_end == 'Z')
@@ -746,13 +788,8 @@ bool CharSet::has_lower_range() {
     case CHARACTER_ITEM:
       break;
     case CHAR_CLASS_ITEM:
-      switch (it->character) {
-      case 'w':
-      case 'D':
-      case 'S':
-      case '.':
+      if (in_char_class(it->character, 'a'))
         return true;
-      }
       break;
     case CHAR_RANGE_ITEM:
       if (it->range_start == 'a' && it->range_end == 'z')
@@ -770,13 +807,8 @@ bool CharSet::has_digit_range() {
     case CHARACTER_ITEM:
       break;
     case CHAR_CLASS_ITEM:
-      switch (it->character) {
-      case 'w':
-      case 'd':
-      case 'S':
-      case '.':
+      if (in_char_class(it->character, '0'))
         return true;
-      }
       break;
     case CHAR_RANGE_ITEM:
       if (it->range_start == '0' && it->range_end == '9')
@@ -813,7 +845,7 @@ std::string CharSet::fix_bad_range(Location loc) {
       char end = regex[i + 1];
       if (is_good_range(start, end)) {
         new_charset += '-';
-      } else if (ispunct(start) || ispunct(end)) {
+      } else if (is_punct_char(start) || is_punct_char(end)) {
         punc_range_found = true;
       } else if (start == 'A' && end == 'z') {
         if (has_upper) {
@@ -957,7 +989,7 @@ std::string CharSet::fix_comma_bar_charset(Location loc, char elim) {
       char end = regex[i + 1];
       if (is_good_range(start, end)) {
         new_charset += '-';
-      } else if (ispunct(start) || ispunct(end)) {
+      } else if (is_punct_char(start) || is_punct_char(end)) {
         punc_range_found = true;
       }
     } else {
@@ -992,12 +1024,13 @@ std::string CharSet::replace_charset_with_parens(Location loc) {
 
 std::vector<std::string>
 CharSet::gen_evil_strings(const std::string& test_string,
+                          const std::string &prefix,
                           const std::set<char> &punct_marks) {
-  std::set<char> test_chars = create_test_chars(punct_marks);
+  const std::set<char> &test_chars = get_test_chars(punct_marks);
   std::string suffix = test_string.substr(prefix.size() + 1);
   std::vector<std::string> evil_strings;
 
-  std::set<char>::iterator cs;
+  std::set<char>::const_iterator cs;
   for (cs = test_chars.begin(); cs != test_chars.end(); cs++) {
     std::string new_string = prefix;
     new_string += *cs;
@@ -1007,6 +1040,28 @@ CharSet::gen_evil_strings(const std::string& test_string,
   return evil_strings;
 }
 
+const std::set<char> &
+CharSet::get_test_chars(const std::set<char> &punct_marks) {
+  if (!cache->has_test_chars || cache->punct_marks != punct_marks) {
+    cache->test_chars = create_test_chars(punct_marks);
+    cache->punct_marks = punct_marks;
+    cache->has_test_chars = true;
+
+    // characters in the same class are treated the same by the whole regex,
+    // so only keep the first test character of each class
+    if (cache->alphabet) {
+      std::set<unsigned int> classes;
+      for (auto it = cache->test_chars.begin(); it != cache->test_chars.end();) {
+        if (classes.insert((*cache->alphabet)[(unsigned char)*it]).second)
+          it++;
+        else
+          it = cache->test_chars.erase(it);
+      }
+    }
+  }
+  return cache->test_chars;
+}
+
 std::set<char> CharSet::create_test_chars(const std::set<char> &punct_marks) {
   std::set<char> test_chars;
   bool lowercase_flag = false;
@@ -1018,6 +1073,13 @@ std::set<char> CharSet::create_test_chars(const std::set<char> &punct_marks) {
   bool uppercase[26];
   bool digits[10];
 
+  // the alternatives of an alternation are its only test characters
+  if (alternation) {
+    for (const CharSetItem &item : items)
+      test_chars.insert(item.character);
+    return test_chars;
+  }
+
   for (int i = 0; i < 26; i++) {
 
     lowercase[i] = false;
@@ -1035,13 +1097,13 @@ std::set<char> CharSet::create_test_chars(const std::set<char> &punct_marks) {
       test_chars.insert(c);
 
       // Set flags properly
-      if (islower(c)) {
+      if (is_lower_char(c)) {
         lowercase_flag = true;
         lowercase[c - 'a'] = true;
-      } else if (isupper(c)) {
+      } else if (is_upper_char(c)) {
         uppercase_flag = true;
         uppercase[c - 'A'] = true;
-      } else if (isdigit(c)) {
+      } else if (is_digit_char(c)) {
         digit_flag = true;
         digits[c - '0'] = true;
       }
@@ -23,6 +23,9 @@
 #define CHARSET_H
 
 #include "Util.h"
+#include <bitset>
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
@@ -44,26 +47,76 @@ struct CharSetItem {
   char range_end;   // for CHAR_RANGE_ITEM
 };
 
+// Data derived from the items of a character set, shared by all sets in a
+// regex with the same items
+struct CharSetCache {
+  std::bitset<256> members;    // accepted characters
+  bool has_test_chars = false; // set once test_chars is computed
+  std::set<char> punct_marks;  // punctuation marks used for test_chars
+  std::set<char> test_chars;   // characters used for evil strings
+  std::shared_ptr<const std::vector<unsigned int>>
+      alphabet; // class of each character in the regex's alphabet partition
+};
+
+// Pool of character set caches for one regex
+class CharSetPool {
+
+public:
+  // returns the cache for the key, adding the given cache if the key is new
+  std::shared_ptr<CharSetCache>
+  intern(const std::string &key, const std::shared_ptr<CharSetCache> &cache);
+
+  // splits the characters into classes that every set in the pool and the
+  // given characters treat the same, evil strings then use one test
+  // character per class
+  void partition_alphabet(const std::set<char> &chars);
+
+  // accessors
+  unsigned int get_num_sets() const { return caches.size(); }
+  unsigned int get_num_shared() const { return num_shared; }
+  unsigned int get_num_classes() const { return num_classes; }
+
+private:
+  std::map<std::string, std::shared_ptr<CharSetCache>> caches; // by key
+  unsigned int num_shared{}; // sets that reused a cache
+  unsigned int num_classes{}; // classes in the alphabet partition
+};
+
 class CharSet {
 
 public:
   CharSet() {
     complement = false;
+    alternation = false;
     checked = false;
+    cache = std::make_shared<CharSetCache>();
   }
 
   // setters
-  void set_prefix(std::string p) { prefix = std::move(p); }
-  void set_complement(bool c) { complement = c; }
+  void set_complement(bool c);
+
+  // marks a set built from an alternation of characters, it is tested with
+  // its own characters only, as the alternatives would be
+  void set_alternation(bool a);
 
   // getters
   bool is_complement() const { return complement; }
 
+  // clears the state set by checking paths
+  void reset() { checked = false; }
+
   // CONSTRUCTION FUNCTIONS
 
   // add an item to the character set
   void add_item(CharSetItem item);
 
+  // shares the derived data with identical sets in the pool, called once
+  // all items are added
+  void intern(CharSetPool &pool);
+
+  // returns the key identifying sets with the same items
+  std::string get_key() const;
+
   // PROPERTY FUNCTIONS
 
   // returns true if character set is a single character
@@ -81,6 +134,10 @@ public:
   // returns true if character set only has punctuation and spaces
   bool only_has_punc_and_spaces();
 
+  // returns true if the set has a class that is only approximated (\s only
+  // matches a space, \S and . match every other character)
+  bool has_approximate_class();
+
   // determines if a character is valid
   bool is_valid_character(char character);
 
@@ -107,8 +164,9 @@ public:
 
   // TEST GENERATION FUNCTIONS
 
-  // generate evil strings
+  // generate evil strings, prefix is the path string before the character
   std::vector<std::string> gen_evil_strings(const std::string& test_string,
+                                            const std::string &prefix,
                                             const std::set<char> &punct_marks);
 
   // PRINT FUNCTION
@@ -119,8 +177,12 @@ public:
 private:
   std::vector<CharSetItem> items; // set of items comprising the set
   bool complement;                // true if set is complemented
-  std::string prefix;             // path string up to visiting this node
+  bool alternation;               // true if built from an alternation
   bool checked;                   // true of charset has been checked
+  std::shared_ptr<CharSetCache> cache; // derived data (may be shared)
+
+  // makes the cache private before the items change
+  void own_cache();
 
   // checker functions
   bool only_has_punc(bool allow_spaces = false);
@@ -136,6 +198,9 @@ private:
 
   // creates a set of test characters
   std::set<char> create_test_chars(const std::set<char> &punct_marks);
+
+  // returns the test characters, creating them if not cached
+  const std::set<char> &get_test_chars(const std::set<char> &punct_marks);
 };
 
 #endif // CHARSET_H
@@ -20,23 +20,27 @@
 */
 
 #include "Checker.h"
+#include "BacktrackChecker.h"
 #include "Path.h"
 #include "Util.h"
 #include <iostream>
 #include <set>
-#include <sstream>
 #include <vector>
 
 // Checker
 
 void Checker::check() {
-  check_anchor_usage();
-  check_anchor_in_middle();
-  check_charsets();
-  check_optional_braces();
-  check_wild_punctuation();
-  check_repeat_punctuation();
-  check_digit_too_optional();
+  // rules run in order, stopping once the alert limit is reached
+  void (Checker::*rules[])() = {
+      &Checker::check_anchor_usage,       &Checker::check_anchor_in_middle,
+      &Checker::check_charsets,           &Checker::check_optional_braces,
+      &Checker::check_wild_punctuation,   &Checker::check_repeat_punctuation,
+      &Checker::check_digit_too_optional, &Checker::check_backtracking};
+  for (auto rule : rules) {
+    if (Util::get()->alert_limit_reached())
+      return;
+    (this->*rule)();
+  }
 }
 
 // CHECKER FUNCTIONS
@@ -47,11 +51,8 @@ void Checker::check_anchor_usage() {
   bool warn_caret_start = false;
   bool warn_dollar_end = false;
 
-  // get end of line marker
-  std::string eol = Util::get()->is_web_mode() ? "<br>" : "\n";
-
   bool is_first_string = true;
-  std::string first_string;
+  std::vector<Path>::iterator first_path;
   std::vector<Path>::iterator path_iter;
   for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
 
@@ -64,7 +65,7 @@ void Checker::check_anchor_usage() {
       all_start_with_caret = start_with_caret;
       all_end_with_dollar = end_with_dollar;
       is_first_string = false;
-      first_string = path_iter->get_test_string();
+      first_path = path_iter;
     }
 
     // print warning (but only for first occurrence of each anchor)
@@ -72,22 +73,22 @@ void Checker::check_anchor_usage() {
       if (all_start_with_caret && !start_with_caret) {
         std::string curr_string = path_iter->get_test_string();
 
-        std::stringstream s;
-        s << "Some but not all strings start with a ^ anchor" << eol;
-        s << "...String with ^ anchor: " << first_string << eol;
-        s << "...String with no ^ anchor: " << curr_string;
-        Alert a("anchor usage", s.str(), fix_anchors());
+        Alert a("anchor usage",
+                "Some but not all strings start with a ^ anchor",
+                fix_anchors());
+        a.add_detail("String with ^ anchor", first_path->get_test_string());
+        a.add_detail("String with no ^ anchor", curr_string);
         Util::get()->add_alert(a);
         warn_caret_start = true;
       }
       if (!all_start_with_caret && start_with_caret) {
         std::string curr_string = path_iter->get_test_string();
 
-        std::stringstream s;
-        s << "Some but not all strings start with a ^ anchor" << eol;
-        s << "...String with ^ anchor: " << curr_string << eol;
-        s << "...String with no ^ anchor: " << first_string;
-        Alert a("anchor usage", s.str(), fix_anchors());
+        Alert a("anchor usage",
+                "Some but not all strings start with a ^ anchor",
+                fix_anchors());
+        a.add_detail("String with ^ anchor", curr_string);
+        a.add_detail("String with no ^ anchor", first_path->get_test_string());
         Util::get()->add_alert(a);
         warn_caret_start = true;
       }
@@ -96,22 +97,22 @@ void Checker::check_anchor_usage() {
       if (all_end_with_dollar && !end_with_dollar) {
         std::string curr_string = path_iter->get_test_string();
 
-        std::stringstream s;
-        s << "Some but not all strings end with a $ anchor" << eol;
-        s << "...String with $ anchor: " << first_string << eol;
-        s << "...String with no $ anchor: " << curr_string;
-        Alert a("anchor usage", s.str(), fix_anchors());
+        Alert a("anchor usage",
+                "Some but not all strings end with a $ anchor",
+                fix_anchors());
+        a.add_detail("String with $ anchor", first_path->get_test_string());
+        a.add_detail("String with no $ anchor", curr_string);
         Util::get()->add_alert(a);
         warn_dollar_end = true;
       }
       if (!all_end_with_dollar && end_with_dollar) {
         std::string curr_string = path_iter->get_test_string();
 
-        std::stringstream s;
-        s << "Some but not all strings end with a $ anchor" << eol;
-        s << "...String with $ anchor: " << curr_string << eol;
-        s << "...String with no $ anchor: " << first_string;
-        Alert a("anchor usage", s.str(), fix_anchors());
+        Alert a("anchor usage",
+                "Some but not all strings end with a $ anchor",
+                fix_anchors());
+        a.add_detail("String with $ anchor", curr_string);
+        a.add_detail("String with no $ anchor", first_path->get_test_string());
         Util::get()->add_alert(a);
         warn_dollar_end = true;
       }
@@ -128,34 +129,88 @@ void Checker::check_anchor_in_middle() {
 
 void Checker::check_charsets() {
   for (auto &path : paths) {
+    if (Util::get()->alert_limit_reached())
+      return;
     path.check_charsets();
   }
 }
 
 void Checker::check_optional_braces() {
   for (auto &path : paths) {
+    if (Util::get()->alert_limit_reached())
+      return;
     path.check_optional_braces();
   }
 }
 
 void Checker::check_wild_punctuation() {
   for (auto &path : paths) {
+    if (Util::get()->alert_limit_reached())
+      return;
     path.check_wild_punctuation();
   }
 }
 
 void Checker::check_repeat_punctuation() {
   for (auto &path : paths) {
+    if (Util::get()->alert_limit_reached())
+      return;
     path.check_repeat_punctuation();
   }
 }
 
 void Checker::check_digit_too_optional() {
   for (auto &path : paths) {
+    if (Util::get()->alert_limit_reached())
+      return;
     path.check_digit_too_optional();
   }
 }
 
+void Checker::check_backtracking() {
+  BacktrackChecker backtrack_checker(nfa);
+  std::vector<BacktrackAttack> attacks = backtrack_checker.find_attacks();
+
+  // searches cut off by their limits may have missed ambiguous repetitions
+  backtrack_cut_offs = backtrack_checker.get_cut_offs();
+  if (backtrack_cut_offs > 0) {
+    Alert a("analysis incomplete",
+            "Backtracking analysis reached its search limits, some "
+            "repetitions were not fully checked");
+    a.warning = true;
+    a.incomplete = true;
+    Util::get()->add_alert(a);
+  }
+
+  for (const BacktrackAttack &attack : attacks) {
+    if (Util::get()->alert_limit_reached())
+      return;
+    std::string type;
+    std::string msg;
+    unsigned int pumps;
+    if (attack.exponential) {
+      type = "exponential backtracking";
+      msg = "Repetition can match the same string in more than one way";
+      pumps = EXPONENTIAL_PUMPS;
+    } else {
+      type = "polynomial backtracking";
+      msg = "Adjacent repetitions can match the same string";
+      pumps = POLYNOMIAL_PUMPS;
+    }
+
+    Alert a(type, msg, attack.loc1);
+    if (attack.loc2 != attack.loc1 && attack.loc2.first != -1)
+      a.loc2 = attack.loc2;
+    a.add_detail("Pump string", attack.pump);
+    a.add_detail("Attack string", attack.gen_attack_string(pumps));
+    Util::get()->add_alert(a);
+  }
+}
+
+void Checker::add_stats(Stats &stats) {
+  stats.add("CHECKER", "Backtracking searches cut off", backtrack_cut_offs);
+}
+
 std::string Checker::fix_anchors() {
   std::string new_regex = "^(";
   std::string regex = Util::get()->get_regex();
@@ -22,8 +22,10 @@
 #ifndef CHECKER_H
 #define CHECKER_H
 
+#include "NFA.h"
 #include "Path.h"
 #include "Scanner.h"
+#include "Stats.h"
 #include <set>
 #include <string>
 #include <utility>
@@ -32,7 +34,7 @@
 class Checker {
 
 public:
-  Checker(std::vector<Path> p, std::vector<Token> t) {
+  Checker(std::vector<Path> p, std::vector<Token> t, const NFA &n) : nfa(n) {
     paths = std::move(p);
     tokens = std::move(t);
   }
@@ -40,9 +42,14 @@ public:
   // checker entry point
   void check();
 
+  // add stats
+  void add_stats(Stats &stats);
+
 private:
   std::vector<Path> paths;   // list of paths
   std::vector<Token> tokens; // set of tokens - used for generated fixes
+  const NFA &nfa;            // NFA - used for backtracking analysis
+  unsigned int backtrack_cut_offs{}; // backtracking searches cut off
 
   // CHECKER FUNCTIONS
 
@@ -67,6 +74,9 @@ private:
   // checks if digits are too optional
   void check_digit_too_optional();
 
+  // checks for repetitions that cause catastrophic backtracking
+  void check_backtracking();
+
   // fix anchors
   std::string fix_anchors();
 };
@@ -0,0 +1,174 @@
+/*  CompiledRegex.cpp: regex compiled once for repeated queries
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CompiledRegex.h"
+#include "Checker.h"
+#include "ParseTree.h"
+#include "TestGenerator.h"
+#include "Util.h"
+#include <regex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+CompiledRegex::CompiledRegex(std::string r) {
+  regex = std::move(r);
+
+  try {
+    // scan with test generation rules, falling back to the more lenient
+    // check mode rules if the regex is only supported by the checker
+    Scanner scanner;
+    try {
+      Util::get()->init(regex, false, "evil");
+      scanner.init(regex);
+    } catch (EgretException const &e) {
+      gen_error = e.get_error();
+      Util::get()->init(regex, true, "evil");
+      scanner = Scanner();
+      scanner.init(regex);
+    }
+    warnings = Util::get()->get_alerts();
+    tokens = scanner.get_tokens();
+
+    ParseTree tree;
+    tree.build(scanner);
+    punct_marks = tree.get_punct_marks();
+
+    nfa.build(tree);
+    nfa.optimize();
+    paths = nfa.find_basis_paths(std::thread::hardware_concurrency());
+  } catch (EgretException const &e) {
+    throw std::runtime_error(e.get_error());
+  }
+}
+
+void CompiledRegex::reset() { nfa.reset(); }
+
+void CompiledRegex::process_paths(bool check_mode,
+                                  const std::string &base_substring) {
+  Util::check_base_substring(base_substring);
+  Util::get()->init(regex, check_mode, base_substring);
+  reset();
+  for (auto &path : paths)
+    path.reset();
+}
+
+EgretResult CompiledRegex::check(const std::string &base_substring) {
+  EgretResult result;
+  result.regex = regex;
+  try {
+    process_paths(true, base_substring);
+    Checker checker(paths, tokens, nfa);
+    checker.check();
+  } catch (EgretException const &e) {
+    throw std::runtime_error(e.get_error());
+  }
+
+  result.alerts = Util::get()->get_alerts();
+  return result;
+}
+
+EgretResult CompiledRegex::generate(const std::string &base_substring,
+                                    unsigned int max_strings) {
+  if (!gen_error.empty())
+    throw std::runtime_error(gen_error);
+
+  EgretResult result;
+  result.regex = regex;
+  try {
+    process_paths(false, base_substring);
+    TestGenerator gen(paths, punct_marks, false);
+    if (max_strings == 0) {
+      result.test_strings = gen.gen_test_strings();
+    } else {
+      std::string test_string;
+      while (result.test_strings.size() < max_strings &&
+             gen.next_test_string(test_string))
+        result.test_strings.push_back(test_string);
+    }
+  } catch (EgretException const &e) {
+    throw std::runtime_error(e.get_error());
+  }
+
+  // scanner warnings followed by the warnings of the generation
+  result.alerts = warnings;
+  const std::vector<Alert> &gen_alerts = Util::get()->get_alerts();
+  result.alerts.insert(result.alerts.end(), gen_alerts.begin(),
+                       gen_alerts.end());
+  return result;
+}
+
+void CompiledRegex::start_generate(const std::string &base_substring) {
+  if (!gen_error.empty())
+    throw std::runtime_error(gen_error);
+
+  try {
+    process_paths(false, base_substring);
+  } catch (EgretException const &e) {
+    throw std::runtime_error(e.get_error());
+  }
+  generator = std::unique_ptr<TestGenerator>(
+      new TestGenerator(paths, punct_marks, false));
+  gen_options = std::make_shared<Util>(*Util::get());
+}
+
+bool CompiledRegex::next_test_string(std::string &test_string) {
+  if (!generator)
+    return false;
+
+  // other queries may have changed the global options since the last string,
+  // swap in the generator's options and swap the caller's back afterwards
+  Util &options = *Util::get();
+  std::swap(options, *gen_options);
+  bool found;
+  try {
+    found = generator->next_test_string(test_string);
+  } catch (EgretException const &e) {
+    std::swap(options, *gen_options);
+    throw std::runtime_error(e.get_error());
+  }
+  std::swap(options, *gen_options);
+
+  if (!found) {
+    generator.reset();
+    gen_options.reset();
+  }
+  return found;
+}
+
+bool CompiledRegex::match(const std::string &str) {
+  if (!dfa)
+    dfa = std::unique_ptr<DFA>(new DFA(nfa));
+  if (dfa->is_exact())
+    return dfa->accepts(str);
+
+  // the DFA only approximates the regex, its answer could be wrong
+  try {
+    if (!matcher)
+      matcher = std::unique_ptr<std::regex>(
+          new std::regex(regex, std::regex::ECMAScript));
+    return std::regex_match(str, *matcher);
+  } catch (std::regex_error const &e) {
+    throw std::runtime_error(
+        std::string("ERROR (unsupported): regex cannot be matched exactly: ") +
+        e.what());
+  }
+}
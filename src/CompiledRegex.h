@@ -0,0 +1,92 @@
+/*  CompiledRegex.h: regex compiled once for repeated queries
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPILED_REGEX_H
+#define COMPILED_REGEX_H
+
+#include "DFA.h"
+#include "NFA.h"
+#include "Path.h"
+#include "Scanner.h"
+#include "TestGenerator.h"
+#include "egret.h"
+#include <memory>
+#include <regex>
+#include <set>
+#include <string>
+#include <vector>
+
+// A regex that is scanned, parsed and converted to an NFA once. The NFA and
+// its basis paths are reset before each query, so the regex can be checked,
+// used to generate tests with any base substring, and matched repeatedly.
+// Errors are thrown as std::runtime_error, as with run_engine.
+class CompiledRegex {
+
+public:
+  explicit CompiledRegex(std::string r);
+
+  // runs the checker, returns the violations
+  EgretResult check(const std::string &base_substring = "evil");
+
+  // generates tests, returns the warnings and test strings in generation
+  // order. A nonzero max_strings stops once that many strings are generated,
+  // the strings are then the first ones returned by next_test_string.
+  EgretResult generate(const std::string &base_substring,
+                       unsigned int max_strings = 0);
+
+  // starts generating tests, the strings are then generated as they are
+  // taken by next_test_string
+  void start_generate(const std::string &base_substring);
+
+  // sets the next test string of the generation started by start_generate,
+  // returns false once there are no strings left. The generator runs with
+  // the global options it was started with, the options of the caller are
+  // restored afterwards.
+  bool next_test_string(std::string &test_string);
+
+  // returns true if the regex matches the entire string, throws a
+  // runtime_error if the DFA is not exact and std::regex cannot match it
+  bool match(const std::string &str);
+
+  // clears the state left on the NFA by the previous query
+  void reset();
+
+  // accessors
+  std::string get_regex() const { return regex; }
+
+private:
+  std::string regex;                   // original regular expression
+  std::string gen_error;               // set if test generation unsupported
+  std::vector<Alert> warnings;         // warnings emitted by the scanner
+  std::vector<Token> tokens;           // tokens - used for generated fixes
+  std::set<char> punct_marks;          // punctuation marks in regex
+  NFA nfa;                             // optimized NFA
+  std::vector<Path> paths;             // basis paths of the NFA
+  std::unique_ptr<DFA> dfa;            // DFA built on first match
+  std::unique_ptr<std::regex> matcher; // used when the DFA is not exact
+  std::unique_ptr<TestGenerator> generator; // started by start_generate
+  std::shared_ptr<Util> gen_options;   // global options of the generator
+
+  // resets the NFA and paths for checking or test generation
+  void process_paths(bool check_mode, const std::string &base_substring);
+};
+
+#endif // COMPILED_REGEX_H
@@ -0,0 +1,195 @@
+/*  DFA.cpp: lazily constructed deterministic automaton
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DFA.h"
+#include <algorithm>
+#include <set>
+#include <utility>
+
+// Special values for DFA transitions
+static const int DEAD_STATE = -1;
+static const int UNKNOWN_STATE = -2;
+
+DFA::DFA(const NFA &nfa) : automaton(nfa) {
+  num_strings = 0;
+  num_accepted = 0;
+  compute_byte_classes();
+  find_state(std::vector<unsigned int>(1, automaton.get_initial()));
+}
+
+void DFA::compute_byte_classes() {
+  // refine the partition of bytes by each distinct label
+  byte_class.assign(256, 0);
+  num_classes = 1;
+  std::set<std::string> seen;
+  for (const CharAutomaton::Transition &t : automaton.get_transitions()) {
+    if (!seen.insert(t.label.to_string()).second)
+      continue;
+    std::map<std::pair<unsigned int, bool>, unsigned int> split;
+    for (unsigned int c = 0; c < 256; c++) {
+      auto key = std::make_pair(byte_class[c], (bool)t.label.test(c));
+      auto it = split.find(key);
+      if (it == split.end())
+        it = split.insert(std::make_pair(key, split.size())).first;
+      byte_class[c] = it->second;
+    }
+    num_classes = split.size();
+  }
+
+  class_rep.assign(num_classes, 0);
+  for (int c = 255; c >= 0; c--)
+    class_rep[byte_class[c]] = (unsigned char)c;
+}
+
+int DFA::find_state(std::vector<unsigned int> states) {
+  const std::vector<std::vector<unsigned int>> &eps = automaton.get_epsilons();
+  const std::vector<std::vector<unsigned int>> &trans_out =
+      automaton.get_transitions_out();
+
+  // epsilon closure, keeping only states that matter for future steps
+  std::vector<bool> seen(automaton.get_num_states(), false);
+  std::vector<unsigned int> work = states;
+  std::vector<unsigned int> closure;
+  for (unsigned int state : states)
+    seen[state] = true;
+  while (!work.empty()) {
+    unsigned int state = work.back();
+    work.pop_back();
+    if (!trans_out[state].empty() || state == automaton.get_final())
+      closure.push_back(state);
+    for (unsigned int next_state : eps[state]) {
+      if (!seen[next_state]) {
+        seen[next_state] = true;
+        work.push_back(next_state);
+      }
+    }
+  }
+  if (closure.empty())
+    return DEAD_STATE;
+  std::sort(closure.begin(), closure.end());
+
+  auto it = cache.find(closure);
+  if (it != cache.end())
+    return it->second;
+
+  int id = state_sets.size();
+  cache[closure] = id;
+  accepting.push_back(std::binary_search(closure.begin(), closure.end(),
+                                         automaton.get_final()));
+  state_sets.push_back(std::move(closure));
+  next.push_back(std::vector<int>(num_classes, UNKNOWN_STATE));
+  state_covered.push_back(false);
+  trans_covered.push_back(std::vector<bool>(num_classes, false));
+  return id;
+}
+
+int DFA::step(int state, unsigned int byte_class) {
+  int next_state = next[state][byte_class];
+  if (next_state != UNKNOWN_STATE)
+    return next_state;
+
+  const std::vector<CharAutomaton::Transition> &trans =
+      automaton.get_transitions();
+  const std::vector<std::vector<unsigned int>> &trans_out =
+      automaton.get_transitions_out();
+  unsigned char c = class_rep[byte_class];
+
+  std::vector<unsigned int> targets;
+  for (unsigned int s : state_sets[state]) {
+    for (unsigned int i : trans_out[s]) {
+      if (trans[i].label.test(c))
+        targets.push_back(trans[i].to);
+    }
+  }
+  std::sort(targets.begin(), targets.end());
+  targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+
+  next_state = targets.empty() ? DEAD_STATE : find_state(targets);
+  next[state][byte_class] = next_state;
+  return next_state;
+}
+
+bool DFA::run(const std::string &str, bool mark) {
+  int state = 0;
+  if (mark)
+    state_covered[state] = true;
+  for (char c : str) {
+    unsigned int cls = byte_class[(unsigned char)c];
+    int next_state = step(state, cls);
+    if (next_state == DEAD_STATE)
+      return false;
+    if (mark) {
+      trans_covered[state][cls] = true;
+      state_covered[next_state] = true;
+    }
+    state = next_state;
+  }
+  return accepting[state];
+}
+
+bool DFA::accepts(const std::string &str) { return run(str, false); }
+
+bool DFA::cover(const std::string &str) {
+  bool accepted = run(str, true);
+  num_strings++;
+  if (accepted)
+    num_accepted++;
+  return accepted;
+}
+
+bool DFA::expand(unsigned int max_states) {
+  for (unsigned int state = 0; state < state_sets.size(); state++) {
+    for (unsigned int cls = 0; cls < num_classes; cls++) {
+      if (state_sets.size() >= max_states)
+        return false;
+      step(state, cls);
+    }
+  }
+  return true;
+}
+
+DFACoverage DFA::get_coverage() {
+  DFACoverage coverage = {0, 0, 0, 0};
+  for (unsigned int state = 0; state < state_sets.size(); state++) {
+    coverage.states++;
+    if (state_covered[state])
+      coverage.covered_states++;
+    for (unsigned int cls = 0; cls < num_classes; cls++) {
+      if (next[state][cls] < 0)
+        continue;
+      coverage.transitions++;
+      if (trans_covered[state][cls])
+        coverage.covered_transitions++;
+    }
+  }
+  return coverage;
+}
+
+void DFA::add_stats(Stats &stats) {
+  DFACoverage coverage = get_coverage();
+  stats.add("DFA", "DFA byte classes", num_classes);
+  stats.add("DFA", "DFA states", coverage.states);
+  stats.add("DFA", "DFA transitions", coverage.transitions);
+  stats.add("DFA", "DFA covered states", coverage.covered_states);
+  stats.add("DFA", "DFA covered transitions", coverage.covered_transitions);
+  stats.add("DFA", "Accepted test strings", num_accepted);
+  stats.add("DFA", "Rejected test strings", num_strings - num_accepted);
+}
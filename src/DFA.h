@@ -0,0 +1,100 @@
+/*  DFA.h: lazily constructed deterministic automaton
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DFA_H
+#define DFA_H
+
+#include "CharAutomaton.h"
+#include "NFA.h"
+#include "Stats.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// Limit on the number of states computed when expanding the DFA
+const unsigned int MAX_DFA_STATES = 10000;
+
+// Coverage of the DFA by the strings passed to DFA::cover
+struct DFACoverage {
+  unsigned long states;              // number of computed states
+  unsigned long covered_states;      // states visited by a string
+  unsigned long transitions;         // number of computed (live) transitions
+  unsigned long covered_transitions; // transitions taken by a string
+};
+
+// A DFA built by subset construction from the character level automaton.
+// States are computed when first needed and cached. Bytes that every
+// transition treats the same way share a byte class, so transitions are
+// stored per class rather than per byte.
+class DFA {
+
+public:
+  explicit DFA(const NFA &nfa);
+
+  // returns true if the string is accepted
+  bool accepts(const std::string &str);
+
+  // runs the string through the DFA, marking the states and transitions
+  // used as covered, returns true if the string is accepted
+  bool cover(const std::string &str);
+
+  // computes all reachable states, returns false if the limit was reached
+  bool expand(unsigned int max_states);
+
+  // returns coverage of the computed states and transitions
+  DFACoverage get_coverage();
+
+  // accessors
+  unsigned int get_num_states() const { return state_sets.size(); }
+  unsigned int get_num_classes() const { return num_classes; }
+  bool is_exact() const { return automaton.is_exact(); }
+
+  // add DFA stats
+  void add_stats(Stats &stats);
+
+private:
+  CharAutomaton automaton;                       // underlying automaton
+  unsigned int num_classes;                      // number of byte classes
+  std::vector<unsigned int> byte_class;          // class of each byte
+  std::vector<unsigned char> class_rep;          // byte for each class
+  std::map<std::vector<unsigned int>, int> cache; // state set to DFA state
+  std::vector<std::vector<unsigned int>> state_sets; // DFA state to set
+  std::vector<bool> accepting;                   // accepting DFA states
+  std::vector<std::vector<int>> next;            // transitions per class
+  std::vector<bool> state_covered;               // states visited
+  std::vector<std::vector<bool>> trans_covered;  // transitions taken
+  unsigned long num_strings;                     // strings covered
+  unsigned long num_accepted;                    // covered strings accepted
+
+  // splits the bytes into classes that no transition distinguishes
+  void compute_byte_classes();
+
+  // returns the DFA state for the epsilon closure of a set of states
+  int find_state(std::vector<unsigned int> states);
+
+  // returns the next state, computing it if needed
+  int step(int state, unsigned int byte_class);
+
+  // runs the string through the DFA
+  bool run(const std::string &str, bool mark);
+};
+
+#endif // DFA_H
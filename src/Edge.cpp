@@ -20,7 +20,7 @@
 */
 
 #include "Edge.h"
-#include "Path.h"
+#include "CharClass.h"
 #include "Scanner.h"
 #include <cassert>
 #include <iostream>
@@ -30,46 +30,78 @@
 
 std::shared_ptr<Edge> Edge::epsilon;
 
-bool Edge::process_edge(const std::string &test_string, Path *path) {
-  if (type == BEGIN_LOOP_EDGE) {
-    regex_loop->set_curr_prefix(test_string);
-  }
-  if (type == END_LOOP_EDGE) {
-    regex_loop->set_curr_substring(test_string);
+bool Edge::is_evil() const {
+  switch (type) {
+  case CHAR_SET_EDGE:
+  case STRING_EDGE:
+  case END_LOOP_EDGE:
+  case BACKREFERENCE_EDGE:
+    return true;
+  default:
+    return false;
   }
-  if (type == BACKREFERENCE_EDGE) {
-    backref->set_curr_prefix(test_string);
-    backref->set_curr_substring(
-        path->gen_backref_string(backref->get_group_loc()));
+}
+
+std::shared_ptr<Edge> Edge::copy_shifted(
+    int shift, const std::shared_ptr<CharSet> &c,
+    const std::shared_ptr<RegexLoop> &l) const {
+  Location new_loc = std::make_pair(loc.first + shift, loc.second + shift);
+  switch (type) {
+  case CHAR_SET_EDGE:
+    return std::make_shared<Edge>(type, new_loc, c);
+  case STRING_EDGE:
+    return std::make_shared<Edge>(
+        type, new_loc,
+        std::make_shared<RegexString>(c, regex_str()->get_repeat_lower(),
+                                      regex_str()->get_repeat_upper()));
+  case BEGIN_LOOP_EDGE:
+  case END_LOOP_EDGE:
+    return std::make_shared<Edge>(type, new_loc, l);
+  case BACKREFERENCE_EDGE:
+    return std::make_shared<Edge>(type, new_loc,
+                                  backref_ptr);
+  default:
+    return std::make_shared<Edge>(type, new_loc, character);
   }
+}
 
-  // no further work needed if edge already processed from prior path
-  if (processed)
-    return false;
-  processed = true;
+void Edge::reset() {
+  switch (type) {
+  case CHAR_SET_EDGE:
+    char_set()->reset();
+    break;
+  case STRING_EDGE:
+    regex_str()->reset();
+    break;
+  default:
+    break;
+  }
+}
 
-  // set the path prefix and substring for nodes that need it
-  // and return true for evil edges
+std::string Edge::get_gen_key() {
   switch (type) {
+  case CHARACTER_EDGE:
+    return std::string("c") + character;
   case CHAR_SET_EDGE:
-    char_set->set_prefix(test_string);
-    return true;
+    return "s" + char_set()->get_key();
   case STRING_EDGE:
-    regex_str->set_prefix(test_string);
-    regex_str->set_substring(Util::get()->get_base_substring());
-    return true;
+    return "t" + std::to_string(regex_str()->get_repeat_lower()) + "," +
+           std::to_string(regex_str()->get_repeat_upper()) +
+           regex_str()->get_charset()->get_key();
   case BEGIN_LOOP_EDGE:
-    regex_loop->set_prefix(test_string);
-    return false;
+    return "b" + std::to_string(regex_loop()->get_repeat_lower()) + "," +
+           std::to_string(regex_loop()->get_repeat_upper());
   case END_LOOP_EDGE:
-    regex_loop->set_substring_from_curr();
-    return true;
-  case BACKREFERENCE_EDGE:
-    backref->set_prefix_from_curr();
-    backref->set_substring_from_curr();
-    return true;
+    return "e" + std::to_string(regex_loop()->get_repeat_lower()) + "," +
+           std::to_string(regex_loop()->get_repeat_upper());
+  case CARET_EDGE:
+    return "^";
+  case DOLLAR_EDGE:
+    return "$";
+  case EPSILON_EDGE:
+    return "0";
   default:
-    return false;
+    return "";
   }
 }
 
@@ -82,33 +114,29 @@ std::string Edge::get_substring() {
     return s;
   case CHAR_SET_EDGE:
     // TODO: Does the character field contain a valid character for char set?
-    s += char_set->get_valid_character();
+    s += char_set()->get_valid_character();
     return s;
   case STRING_EDGE:
-    return regex_str->get_substring();
-  case END_LOOP_EDGE:
-    return regex_loop->get_substring();
-  case BACKREFERENCE_EDGE:
-    return backref->get_substring();
+    return Util::get()->get_base_substring();
   default:
     return s;
   }
 }
 
 bool Edge::is_opt_repeat_begin() {
-  return (type == BEGIN_LOOP_EDGE && regex_loop->is_opt_repeat());
+  return (type == BEGIN_LOOP_EDGE && regex_loop()->is_opt_repeat());
 }
 
 bool Edge::is_opt_repeat_end() {
-  return (type == END_LOOP_EDGE && regex_loop->is_opt_repeat());
+  return (type == END_LOOP_EDGE && regex_loop()->is_opt_repeat());
 }
 
 bool Edge::is_wild_candidate() {
-  if (type == CHAR_SET_EDGE && char_set->is_wildcard())
+  if (type == CHAR_SET_EDGE && char_set()->is_wildcard())
     return true;
-  if (type == CHAR_SET_EDGE && char_set->is_complement())
+  if (type == CHAR_SET_EDGE && char_set()->is_complement())
     return true;
-  if (type == STRING_EDGE && regex_str->is_wild_candidate())
+  if (type == STRING_EDGE && regex_str()->is_wild_candidate())
     return true;
   return false;
 }
@@ -116,11 +144,11 @@ bool Edge::is_wild_candidate() {
 bool Edge::is_valid_character(char c) {
   if (type == CHARACTER_EDGE && character == c)
     return true;
-  if (type == CHAR_SET_EDGE && char_set->is_wildcard())
+  if (type == CHAR_SET_EDGE && char_set()->is_wildcard())
     return true;
-  if (type == CHAR_SET_EDGE && char_set->is_valid_character(c))
+  if (type == CHAR_SET_EDGE && char_set()->is_valid_character(c))
     return true;
-  if (type == STRING_EDGE && regex_str->is_valid_character(c))
+  if (type == STRING_EDGE && regex_str()->is_valid_character(c))
     return true;
   return false;
 }
@@ -128,7 +156,7 @@ bool Edge::is_valid_character(char c) {
 bool Edge::is_repeat_begin() {
   if (type != BEGIN_LOOP_EDGE)
     return false;
-  int upper = regex_loop->get_repeat_upper();
+  int upper = regex_loop()->get_repeat_upper();
   if (upper == -1 || upper >= 2)
     return true;
   return false;
@@ -137,54 +165,54 @@ bool Edge::is_repeat_begin() {
 bool Edge::is_repeat_end() {
   if (type != END_LOOP_EDGE)
     return false;
-  int upper = regex_loop->get_repeat_upper();
+  int upper = regex_loop()->get_repeat_upper();
   if (upper == -1 || upper >= 2)
     return true;
   return false;
 }
 
 bool Edge::is_repeat_punc_candidate() {
-  if (type == CHARACTER_EDGE && ispunct(character))
+  if (type == CHARACTER_EDGE && is_punct_char(character))
     return true;
-  if (type == CHAR_SET_EDGE && char_set->is_repeat_punc_candidate())
+  if (type == CHAR_SET_EDGE && char_set()->is_repeat_punc_candidate())
     return true;
   return false;
 }
 
 bool Edge::is_str_repeat_punc_candidate() {
-  return (type == STRING_EDGE && regex_str->is_repeat_punc_candidate());
+  return (type == STRING_EDGE && regex_str()->is_repeat_punc_candidate());
 }
 
 char Edge::get_repeat_punc_char() {
   if (type == CHARACTER_EDGE)
     return character;
   if (type == STRING_EDGE)
-    return regex_str->get_repeat_punc_char();
-  return char_set->get_repeat_punc_char();
+    return regex_str()->get_repeat_punc_char();
+  return char_set()->get_repeat_punc_char();
 }
 
 int Edge::get_repeat_lower_limit() {
   if (type == STRING_EDGE)
-    return regex_str->get_repeat_lower();
-  return regex_loop->get_repeat_lower();
+    return regex_str()->get_repeat_lower();
+  return regex_loop()->get_repeat_lower();
 }
 
 int Edge::get_repeat_upper_limit() {
   if (type == STRING_EDGE)
-    return regex_str->get_repeat_upper();
-  return regex_loop->get_repeat_upper();
+    return regex_str()->get_repeat_upper();
+  return regex_loop()->get_repeat_upper();
 }
 
 bool Edge::is_zero_repeat_begin() {
-  return (type == BEGIN_LOOP_EDGE && regex_loop->get_repeat_lower() == 0);
+  return (type == BEGIN_LOOP_EDGE && regex_loop()->get_repeat_lower() == 0);
 }
 
 bool Edge::is_zero_repeat_end() {
-  return (type == END_LOOP_EDGE && regex_loop->get_repeat_lower() == 0);
+  return (type == END_LOOP_EDGE && regex_loop()->get_repeat_lower() == 0);
 }
 
 bool Edge::is_digit_too_optional_candidate() {
-  return (type == CHAR_SET_EDGE && char_set->is_digit_too_optional_candidate());
+  return (type == CHAR_SET_EDGE && char_set()->is_digit_too_optional_candidate());
 }
 
 std::string Edge::fix_wild_punctuation(char c) const {
@@ -217,35 +245,20 @@ std::string Edge::fix_wild_punctuation(char c) const {
   return fixed_char_set;
 }
 
-void Edge::gen_min_iter_string(std::string &min_iter_string) {
-  switch (type) {
-  case STRING_EDGE:
-    regex_str->gen_min_iter_string(min_iter_string);
-    break;
-  case BEGIN_LOOP_EDGE:
-    regex_loop->set_curr_prefix(min_iter_string);
-    break;
-  case END_LOOP_EDGE:
-    regex_loop->gen_min_iter_string(min_iter_string);
-    break;
-  default:
-    min_iter_string += get_substring();
-    break;
-  }
-}
-
 std::vector<std::string>
 Edge::gen_evil_strings(const std::string &path_string,
+                       const std::string &prefix, const std::string &substring,
                        const std::set<char> &punct_marks) {
   switch (type) {
   case CHAR_SET_EDGE:
-    return char_set->gen_evil_strings(path_string, punct_marks);
+    return char_set()->gen_evil_strings(path_string, prefix, punct_marks);
   case STRING_EDGE:
-    return regex_str->gen_evil_strings(path_string, punct_marks);
+    return regex_str()->gen_evil_strings(path_string, prefix, substring,
+                                         punct_marks);
   case END_LOOP_EDGE:
-    return regex_loop->gen_evil_strings(path_string);
+    return regex_loop()->gen_evil_strings(path_string, prefix, substring, loc);
   case BACKREFERENCE_EDGE:
-    return backref->gen_evil_strings(path_string);
+    return backref()->gen_evil_strings(path_string, prefix, substring);
   default: {
     return {};
   }
@@ -259,19 +272,19 @@ void Edge::print() {
     break;
   case CHAR_SET_EDGE:
     std::cout << "CHAR_SET ";
-    char_set->print();
+    char_set()->print();
     break;
   case STRING_EDGE:
     std::cout << "STRING ";
-    regex_str->print();
+    regex_str()->print();
     break;
   case BEGIN_LOOP_EDGE:
     std::cout << "BEGIN_LOOP ";
-    regex_loop->print();
+    regex_loop()->print();
     break;
   case END_LOOP_EDGE:
     std::cout << "END_LOOP ";
-    regex_loop->print();
+    regex_loop()->print();
     break;
   case CARET_EDGE:
     std::cout << "CARET";
@@ -281,7 +294,7 @@ void Edge::print() {
     break;
   case BACKREFERENCE_EDGE:
     std::cout << "BACKREFERENCE ";
-    backref->print();
+    backref()->print();
     break;
   case EPSILON_EDGE:
     std::cout << "EPSILON";
@@ -27,12 +27,11 @@
 #include "RegexLoop.h"
 #include "RegexString.h"
 #include "Util.h"
+#include <cassert>
 #include <set>
 #include <string>
 #include <memory>
 
-class Path; // used to resolve a circular dependency
-
 typedef enum {
   CHARACTER_EDGE,
   CHAR_SET_EDGE,
@@ -60,53 +59,51 @@ public:
   explicit Edge(EdgeType t)
   : type(t)
   , loc(std::make_pair(-1, -1))
-  , processed(false)
   , character(0) {
   }
 
   Edge(EdgeType t, Location l)
   : type(t)
   , loc(std::move(l))
-  , processed(false)
   , character(0) {
   }
 
   Edge(EdgeType t, Location l, char c)
   : type(t)
   , loc(std::move(l))
-  , processed(false)
   , character(c) {
   }
 
   Edge(EdgeType t, Location l, std::shared_ptr<CharSet> c)
   : type(t)
   , loc(std::move(l))
-  , processed(false)
   , character(0)
-  , char_set(std::move(c)) {
+  , char_set_ptr(std::move(c)) {
+    assert(t == CHAR_SET_EDGE);
   }
 
   Edge(EdgeType t, Location l, std::shared_ptr<RegexString> r)
   : type(t)
   , loc(std::move(l))
-  , processed(false)
   , character(0)
-  , regex_str(std::move(r)) {
+  , regex_str_ptr(std::move(r)) {
+    assert(t == STRING_EDGE);
   }
 
   Edge(EdgeType t, Location l, std::shared_ptr<RegexLoop> r)
   : type(t)
   , loc(std::move(l))
-  , processed(false)
   , character(0)
-  , regex_loop(std::move(r)) {
+  , regex_loop_ptr(std::move(r)) {
+    assert(t == BEGIN_LOOP_EDGE || t == END_LOOP_EDGE);
   }
+
   Edge(EdgeType t, Location l, std::shared_ptr<Backref> b)
   : type(t)
   , loc(std::move(l))
-  , processed(false)
   , character(0)
-  , backref(std::move(b)) {
+  , backref_ptr(std::move(b)) {
+    assert(t == BACKREFERENCE_EDGE);
   }
 
   // accessors
@@ -115,15 +112,42 @@ public:
   char get_character() const { return character; }
   std::shared_ptr<CharSet> get_charset() {
     if (type == STRING_EDGE)
-      return regex_str->get_charset();
-    return char_set;
+      return regex_str()->get_charset();
+    if (type == CHAR_SET_EDGE)
+      return char_set_ptr;
+    return nullptr;
+  }
+  std::shared_ptr<RegexLoop> get_regex_loop() {
+    if (type == BEGIN_LOOP_EDGE || type == END_LOOP_EDGE)
+      return regex_loop_ptr;
+    return nullptr;
+  }
+  std::shared_ptr<Backref> get_backref() {
+    if (type == BACKREFERENCE_EDGE)
+      return backref_ptr;
+    return nullptr;
   }
 
-  // process an edge, returns true if edge should be used in creating evil
-  // strings
-  bool process_edge(const std::string &test_string, Path *path);
+  // clears the state set by checking paths so the edge can be reused
+  void reset();
+
+  // returns a copy of the edge for an identical subexpression that starts
+  // shift characters later, using that subexpression's character set and loop
+  std::shared_ptr<Edge> copy_shifted(int shift,
+                                     const std::shared_ptr<CharSet> &c,
+                                     const std::shared_ptr<RegexLoop> &l) const;
+
+  // returns true if the first path through the edge creates evil strings
+  // for it
+  bool is_evil() const;
+
+  // returns a key that is the same for edges adding the same text to a path
+  // and generating the same evil strings for it, empty for backreferences
+  // since their text depends on the rest of the path
+  std::string get_gen_key();
 
-  // get substring associated with edge
+  // get substring associated with edge, the substrings of loop ends and
+  // backreferences depend on the path so they are left to Path
   std::string get_substring();
 
   // edge property functions - used by checker
@@ -145,11 +169,11 @@ public:
   // creates a regex due to a wild punctuation error
   std::string fix_wild_punctuation(char c) const;
 
-  // generate minimum iteration string
-  void gen_min_iter_string(std::string &min_iter_string);
-
-  // generate evil strings
+  // generate evil strings, prefix and substring are the parts of the path
+  // string before and for the edge's construct
   std::vector<std::string> gen_evil_strings(const std::string &path_string,
+                                            const std::string &prefix,
+                                            const std::string &substring,
                                             const std::set<char> &punct_marks);
 
   // print the edge
@@ -160,12 +184,30 @@ private:
 
   EdgeType type;          // type of edge
   Location loc;           // location within original regex
-  bool processed;         // set if edge is processed
   char character;         // character (for CHARACTER_EDGE)
-  std::shared_ptr<CharSet> char_set;      // character set (for CHAR_SET_EDGE)
-  std::shared_ptr<RegexString> regex_str; // regex string (for STRING_EDGE)
-  std::shared_ptr<RegexLoop> regex_loop;  // regex loop (for BEGIN_LOOP_EDGE and END_LOOP_EDGE)
-  std::shared_ptr<Backref> backref;       // backreference (for BACKREFERENCE_EDGE)
+
+  std::shared_ptr<CharSet> char_set_ptr;      // (for CHAR_SET_EDGE)
+  std::shared_ptr<RegexString> regex_str_ptr; // (for STRING_EDGE)
+  std::shared_ptr<RegexLoop> regex_loop_ptr;  // (for BEGIN/END_LOOP_EDGE)
+  std::shared_ptr<Backref> backref_ptr;       // (for BACKREFERENCE_EDGE)
+
+  // payloads of the edge types, only valid for their type
+  CharSet *char_set() const {
+    assert(type == CHAR_SET_EDGE);
+    return char_set_ptr.get();
+  }
+  RegexString *regex_str() const {
+    assert(type == STRING_EDGE);
+    return regex_str_ptr.get();
+  }
+  RegexLoop *regex_loop() const {
+    assert(type == BEGIN_LOOP_EDGE || type == END_LOOP_EDGE);
+    return regex_loop_ptr.get();
+  }
+  Backref *backref() const {
+    assert(type == BACKREFERENCE_EDGE);
+    return backref_ptr.get();
+  }
 };
 
 #endif // EDGE_H
@@ -25,13 +25,37 @@
 #include "NFA.h"
 #include "Edge.h"
 #include "ParseTree.h"
+#include "PathSearch.h"
 #include "Util.h"
+#include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 // TODO: No location information for epsilon edge.  OK?
 
+struct NFAFragment {
+  NFAFragment(int n, NFA f)
+  : node(n)
+  , nfa(std::move(f)) {
+  }
+
+  int node; // root of the subtree the fragment was built from
+  NFA nfa;  // NFA built for the subtree
+};
+
+// orders the edges leaving a state by the state they lead to
+static bool target_before(const std::pair<unsigned int, std::shared_ptr<Edge>> &target,
+                          unsigned int state) {
+  return target.first < state;
+}
+
 NFA::NFA(unsigned int _size, unsigned int _initial, unsigned int _final)
 : size(_size)
 , initial(_initial)
@@ -40,10 +64,7 @@ NFA::NFA(unsigned int _size, unsigned int _initial, unsigned int _final)
   assert(final < size);
 
   // initialize edge table with an "empty graph"
-  std::vector<std::shared_ptr<Edge>> empty_row(size);
-  for (unsigned int i = 0; i < size; i++) {
-    edge_table.push_back(empty_row);
-  }
+  edge_table.assign(size, EdgeList());
 }
 
 NFA::NFA(const NFA &other) {
@@ -51,6 +72,8 @@ NFA::NFA(const NFA &other) {
   initial = other.initial;
   final = other.final;
   edge_table = other.edge_table;
+  reused_fragments = other.reused_fragments;
+  ignored_elements = other.ignored_elements;
 }
 
 NFA &NFA::operator=(const NFA &other) {
@@ -61,114 +84,322 @@ NFA &NFA::operator=(const NFA &other) {
   final = other.final;
   size = other.size;
   edge_table = other.edge_table;
+  reused_fragments = other.reused_fragments;
+  ignored_elements = other.ignored_elements;
 
   return *this;
 }
 
 void NFA::build(ParseTree &tree) {
-  // Build NFA
-  NFA nfa = build_nfa_from_tree(tree.get_root());
+  const std::vector<ParseNode> &nodes = tree.get_nodes();
+  int root = tree.get_root();
+  reused_fragments = 0;
+  ignored_elements = false;
+
+  // NFA of each subtree, consumed when its parent is built
+  std::vector<NFA> built(nodes.size());
+
+  // first NFA built for each shape that occurs more than once
+  std::unordered_map<int, NFAFragment> fragments;
+
+  // Build the NFAs bottom up. A node is visited twice: first to push the
+  // subtrees it needs, then to build it once they are done.
+  std::vector<std::pair<int, bool>> stack;
+  stack.push_back(std::make_pair(root, false));
+  while (!stack.empty()) {
+    int index = stack.back().first;
+    bool children_done = stack.back().second;
+    stack.pop_back();
+    const ParseNode &node = nodes[index];
+
+    // leaves are cheaper to build than to copy
+    bool reusable = node.shared && node.left != -1;
+
+    if (!children_done) {
+      if (reusable) {
+        auto it = fragments.find(node.shape);
+        if (it != fragments.end()) {
+          reused_fragments++;
+          built[index] = instantiate_fragment(nodes, it->second, index);
+          continue;
+        }
+      }
+
+      stack.push_back(std::make_pair(index, true));
+      std::vector<int> children;
+      get_child_nodes(nodes, index, children);
+      for (auto it = children.rbegin(); it != children.rend(); ++it)
+        stack.push_back(std::make_pair(*it, false));
+      continue;
+    }
+
+    if (node.type == IGNORED_NODE)
+      ignored_elements = true;
+    built[index] = build_nfa_node(nodes, index, built);
+    if (reusable)
+      fragments.insert(
+          std::make_pair(node.shape, NFAFragment(index, built[index])));
+  }
 
   // Copy NFA
+  const NFA &nfa = built[root];
   initial = nfa.initial;
   final = nfa.final;
   size = nfa.size;
   edge_table = nfa.edge_table;
 }
 
-NFA NFA::build_nfa_from_tree(const std::shared_ptr<ParseNode>& tree) {
-  assert(tree);
+void NFA::get_child_nodes(const std::vector<ParseNode> &nodes, int index,
+                          std::vector<int> &children) {
+  const ParseNode &node = nodes[index];
+  switch (node.type) {
+
+  case ALTERNATION_NODE: {
+    // the literal strings go into the trie, except for repeated ones
+    std::set<std::string> words;
+    std::vector<int> alts;
+    get_alternatives(nodes, index, alts);
+    for (int alt : alts) {
+      std::vector<int> chars;
+      if (get_literal_chars(nodes, alt, chars)) {
+        std::string word;
+        for (int c : chars)
+          word += nodes[c].character;
+        if (words.insert(word).second)
+          continue;
+      }
+      children.push_back(alt);
+    }
+    break;
+  }
+
+  case CONCAT_NODE:
+    children.push_back(node.left);
+    children.push_back(node.right);
+    break;
+
+  case REPEAT_NODE:
+    if (!is_regex_string(nodes[node.left], node.repeat_lower,
+                         node.repeat_upper))
+      children.push_back(node.left);
+    break;
+
+  case GROUP_NODE:
+    children.push_back(node.left);
+    break;
+
+  default:
+    break;
+  }
+}
+
+NFA NFA::instantiate_fragment(const std::vector<ParseNode> &nodes,
+                              const NFAFragment &fragment, int index) {
+  // identical subtrees have the same layout in the node array
+  std::unordered_map<const CharSet *, std::shared_ptr<CharSet>> char_sets;
+  int offset = index - fragment.node;
+  for (int i = nodes[fragment.node].first; i <= fragment.node; i++) {
+    if (nodes[i].type == CHAR_SET_NODE)
+      char_sets[nodes[i].char_set.get()] = nodes[i + offset].char_set;
+  }
 
-  switch (tree->type) {
+  // the subtrees have the same locations relative to their start
+  int shift = nodes[index].loc.first - nodes[fragment.node].loc.first;
+
+  // each copy gets its own loops since they record the strings of a path
+  std::unordered_map<const RegexLoop *, std::shared_ptr<RegexLoop>> loops;
+
+  NFA nfa(fragment.nfa);
+  for (EdgeList &edges : nfa.edge_table) {
+    for (auto &target : edges) {
+      auto edge = target.second;
+      if (edge->get_type() == EPSILON_EDGE)
+        continue;
+
+      std::shared_ptr<CharSet> char_set;
+      std::shared_ptr<CharSet> old_char_set = edge->get_charset();
+      if (old_char_set)
+        char_set = char_sets[old_char_set.get()];
+
+      std::shared_ptr<RegexLoop> regex_loop;
+      std::shared_ptr<RegexLoop> old_loop = edge->get_regex_loop();
+      if (old_loop) {
+        regex_loop = loops[old_loop.get()];
+        if (!regex_loop) {
+          regex_loop = std::make_shared<RegexLoop>(
+              old_loop->get_repeat_lower(), old_loop->get_repeat_upper());
+          loops[old_loop.get()] = regex_loop;
+        }
+      }
+
+      target.second = edge->copy_shifted(shift, char_set, regex_loop);
+    }
+  }
+  return nfa;
+}
+
+NFA NFA::build_nfa_node(const std::vector<ParseNode> &nodes, int index,
+                        std::vector<NFA> &built) {
+  const ParseNode &node = nodes[index];
+  switch (node.type) {
 
   case ALTERNATION_NODE:
-    return build_nfa_alternation(tree);
+    return build_nfa_alternation(nodes, index, built);
 
   case CONCAT_NODE:
-    return build_nfa_concat(tree);
+    return build_nfa_concat(node, built);
 
   case REPEAT_NODE:
-    return build_nfa_repeat(tree);
+    return build_nfa_repeat(nodes, node, built);
 
   case GROUP_NODE:
-    return build_nfa_group(tree);
+    return build_nfa_group(node, built);
 
   case CHARACTER_NODE:
-    return build_nfa_character(tree);
+    return build_nfa_character(node);
 
   case CARET_NODE:
-    return build_nfa_caret(tree);
+    return build_nfa_caret(node);
 
   case DOLLAR_NODE:
-    return build_nfa_dollar(tree);
+    return build_nfa_dollar(node);
 
   case CHAR_SET_NODE:
-    return build_nfa_char_set(tree);
+    return build_nfa_char_set(node);
 
   case IGNORED_NODE:
-    return build_nfa_ignored(tree);
+    return build_nfa_ignored(node);
 
   case BACKREFERENCE_NODE:
-    return build_nfa_backreference(tree);
+    return build_nfa_backreference(node);
 
   default:
     throw EgretException("ERROR (internal): Invalid node type in parse tree");
   }
 }
 
-NFA NFA::build_nfa_alternation(const std::shared_ptr<ParseNode> & tree) {
-  NFA nfa1 = build_nfa_from_tree(tree->left);
-  NFA nfa2 = build_nfa_from_tree(tree->right);
-
-  // How this is done: the new nfa must contain all the states in
-  // nfa1 and nfa2, plus new initial and final states.
-  // First will come the new initial state, then nfa1's states, then
-  // nfa2's states, then the new final state.
-
-  // make room for the new initial state
-  nfa1.shift_states(1);
-
-  // make room for nfa1
-  nfa2.shift_states(nfa1.size);
-
-  // create a new nfa and initialize it with (the shifted) nfa2
-  NFA new_nfa(nfa2);
+// An alternation node and the alternation nodes along its right spine are
+// built as one n-ary alternation. Alternatives that are literal strings are
+// factored into a trie rooted at the initial state (cat|car => ca(t|r)), the
+// other alternatives are built as before and connected by epsilon edges. All
+// the pieces are placed into the edge table once, in the order of the
+// alternatives. A repeated literal string is not merged into the trie so that
+// the backtracking check still sees the ambiguity.
+NFA NFA::build_nfa_alternation(const std::vector<ParseNode> &nodes, int index,
+                               std::vector<NFA> &built) {
+  // trie state and edge for each character of the literal alternatives
+  struct TrieEdge {
+    unsigned int from;
+    unsigned int to;
+    int node;
+  };
+  std::vector<TrieEdge> trie_edges;
+  std::map<std::pair<unsigned int, char>, unsigned int> trie_children;
+  std::vector<bool> trie_final(1, false);
+
+  // other alternatives and the state they are placed at
+  std::vector<std::pair<NFA, unsigned int>> pieces;
+
+  unsigned int next_state = 1;
+  std::vector<int> alts;
+  get_alternatives(nodes, index, alts);
+  for (int alt : alts) {
+    std::vector<int> chars;
+    if (get_literal_chars(nodes, alt, chars)) {
+      // find the state of the string in the trie
+      unsigned int state = 0;
+      unsigned int i = 0;
+      for (; i < chars.size(); i++) {
+        auto it = trie_children.find(
+            std::make_pair(state, nodes[chars[i]].character));
+        if (it == trie_children.end())
+          break;
+        state = it->second;
+      }
+      if (i < chars.size() || !trie_final[state]) {
+        for (; i < chars.size(); i++) {
+          unsigned int to = next_state++;
+          trie_children[std::make_pair(state, nodes[chars[i]].character)] = to;
+          trie_final.resize(next_state, false);
+          trie_edges.push_back(TrieEdge{state, to, chars[i]});
+          state = to;
+        }
+        trie_final[state] = true;
+        continue;
+      }
+    }
 
-  // nfa1's states take their places in new_nfa
-  new_nfa.fill_states(nfa1);
+    NFA nfa = std::move(built[alt]);
+    unsigned int nfa_size = nfa.size;
+    pieces.push_back(std::make_pair(std::move(nfa), next_state));
+    next_state += nfa_size;
+  }
 
-  // Set new initial state and the edges from it
-  new_nfa.add_edge(0, nfa1.initial, Edge::make_epsilon());
-  new_nfa.add_edge(0, nfa2.initial, Edge::make_epsilon());
-  new_nfa.initial = 0;
+  // the new final state comes last
+  NFA new_nfa(next_state + 1, 0, next_state);
+  trie_final.resize(next_state, false);
+  for (const TrieEdge &trie_edge : trie_edges) {
+    const ParseNode &node = nodes[trie_edge.node];
+    new_nfa.add_edge(trie_edge.from, trie_edge.to,
+                     std::make_shared<Edge>(CHARACTER_EDGE, node.loc,
+                                            node.character));
+  }
+  for (unsigned int state = 0; state < next_state; state++) {
+    if (trie_final[state])
+      new_nfa.add_edge(state, new_nfa.final, Edge::make_epsilon());
+  }
+  for (const std::pair<NFA, unsigned int> &piece : pieces) {
+    const NFA &nfa = piece.first;
+    unsigned int shift = piece.second;
+    for (unsigned int from = 0; from < nfa.size; from++) {
+      for (const auto &target : nfa.edge_table[from])
+        new_nfa.edge_table[from + shift].push_back(
+            std::make_pair(target.first + shift, target.second));
+    }
+    new_nfa.add_edge(0, nfa.initial + shift, Edge::make_epsilon());
+    new_nfa.add_edge(nfa.final + shift, new_nfa.final, Edge::make_epsilon());
+  }
 
-  // Make up space for the new final state
-  new_nfa.append_empty_state();
+  return new_nfa;
+}
 
-  // Set new final state
-  new_nfa.final = new_nfa.size - 1;
-  new_nfa.add_edge(nfa1.final, new_nfa.final, Edge::make_epsilon());
-  new_nfa.add_edge(nfa2.final, new_nfa.final, Edge::make_epsilon());
+void NFA::get_alternatives(const std::vector<ParseNode> &nodes, int index,
+                           std::vector<int> &alts) {
+  int node = index;
+  while (nodes[node].type == ALTERNATION_NODE) {
+    alts.push_back(nodes[node].left);
+    node = nodes[node].right;
+  }
+  alts.push_back(node);
+}
 
-  return new_nfa;
+bool NFA::get_literal_chars(const std::vector<ParseNode> &nodes, int index,
+                            std::vector<int> &chars) {
+  // the characters of a subtree appear in order in the node array
+  for (int i = nodes[index].first; i <= index; i++) {
+    if (nodes[i].type == CHARACTER_NODE)
+      chars.push_back(i);
+    else if (nodes[i].type != CONCAT_NODE)
+      return false;
+  }
+  return true;
 }
 
-NFA NFA::build_nfa_concat(const std::shared_ptr<ParseNode> &tree) {
-  NFA nfa1 = build_nfa_from_tree(tree->left);
-  NFA nfa2 = build_nfa_from_tree(tree->right);
-  return concat_nfa(nfa1, nfa2);
+NFA NFA::build_nfa_concat(const ParseNode &node, std::vector<NFA> &built) {
+  return concat_nfa(built[node.left], std::move(built[node.right]));
 }
 
-NFA NFA::build_nfa_repeat(const std::shared_ptr<ParseNode> &tree) {
-  int repeat_lower = tree->repeat_lower;
-  int repeat_upper = tree->repeat_upper;
+NFA NFA::build_nfa_repeat(const std::vector<ParseNode> &nodes,
+                          const ParseNode &node, std::vector<NFA> &built) {
+  int repeat_lower = node.repeat_lower;
+  int repeat_upper = node.repeat_upper;
 
   // if repeat represents a string, build a regex string instead
-  if (is_regex_string(tree->left, repeat_lower, repeat_upper))
-    return build_nfa_string(tree);
+  if (is_regex_string(nodes[node.left], repeat_lower, repeat_upper))
+    return build_nfa_string(node, nodes[node.left]);
 
-  // create NFA for repeated segment
-  NFA nfa = build_nfa_from_tree(tree->left);
+  // NFA for repeated segment
+  NFA nfa = std::move(built[node.left]);
 
   // make room for the new initial state
   nfa.shift_states(1);
@@ -181,11 +412,11 @@ NFA NFA::build_nfa_repeat(const std::shared_ptr<ParseNode> &tree) {
   auto regex_loop = std::make_shared<RegexLoop>(repeat_lower, repeat_upper);
 
   // Util new edges
-  // Edge *edge = new Edge(BEGIN_LOOP_EDGE, tree->loc, regex_loop);
-  auto edge = std::make_shared<Edge>(BEGIN_LOOP_EDGE, tree->loc, regex_loop);
+  // Edge *edge = new Edge(BEGIN_LOOP_EDGE, node.loc, regex_loop);
+  auto edge = std::make_shared<Edge>(BEGIN_LOOP_EDGE, node.loc, regex_loop);
   nfa.add_edge(0, nfa.initial, edge); // new initial to old initial
-  // edge = new Edge(END_LOOP_EDGE, tree->loc, regex_loop);
-  edge = std::make_shared<Edge>(END_LOOP_EDGE, tree->loc, regex_loop);
+  // edge = new Edge(END_LOOP_EDGE, node.loc, regex_loop);
+  edge = std::make_shared<Edge>(END_LOOP_EDGE, node.loc, regex_loop);
   nfa.add_edge(nfa.final, nfa.size - 1, edge); // old final to new final
 
   // update states
@@ -195,12 +426,12 @@ NFA NFA::build_nfa_repeat(const std::shared_ptr<ParseNode> &tree) {
   return nfa;
 }
 
-NFA NFA::build_nfa_string(const std::shared_ptr<ParseNode> &tree) {
+NFA NFA::build_nfa_string(const ParseNode &node, const ParseNode &child) {
   NFA nfa(2, 0, 1);
   // RegexString *regex_str = new RegexString(
-  //     tree->left->char_set, tree->repeat_lower, tree->repeat_upper);
-  auto regex_str = std::make_shared<RegexString>(tree->left->char_set, tree->repeat_lower, tree->repeat_upper);
-  Location loc = std::make_pair(tree->left->loc.first, tree->loc.second);
+  //     child.char_set, node.repeat_lower, node.repeat_upper);
+  auto regex_str = std::make_shared<RegexString>(child.char_set, node.repeat_lower, node.repeat_upper);
+  Location loc = std::make_pair(child.loc.first, node.loc.second);
   // Edge *edge = new Edge(STRING_EDGE, loc, regex_str);
   auto edge = std::make_shared<Edge>(STRING_EDGE, loc, std::move(regex_str));
   nfa.add_edge(0, 1, edge);
@@ -208,51 +439,51 @@ NFA NFA::build_nfa_string(const std::shared_ptr<ParseNode> &tree) {
   return nfa;
 }
 
-NFA NFA::build_nfa_group(const std::shared_ptr<ParseNode> &tree) {
-  return build_nfa_from_tree(tree->left);
+NFA NFA::build_nfa_group(const ParseNode &node, std::vector<NFA> &built) {
+  return std::move(built[node.left]);
 }
 
-NFA NFA::build_nfa_character(const std::shared_ptr<ParseNode> &tree) {
+NFA NFA::build_nfa_character(const ParseNode &node) {
   NFA nfa(2, 0, 1); // size = 2, initial = 0 , final = 1
-  // Edge *edge = new Edge(CHARACTER_EDGE, tree->loc, tree->character);
-  auto edge = std::make_shared<Edge>(CHARACTER_EDGE, tree->loc, tree->character);
+  // Edge *edge = new Edge(CHARACTER_EDGE, node.loc, node.character);
+  auto edge = std::make_shared<Edge>(CHARACTER_EDGE, node.loc, node.character);
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
 
-NFA NFA::build_nfa_caret(const std::shared_ptr<ParseNode> &tree) {
+NFA NFA::build_nfa_caret(const ParseNode &node) {
   NFA nfa(2, 0, 1); // size = 2, initial = 0 , final = 1
-  // Edge *edge = new Edge(CARET_EDGE, tree->loc);
-  auto edge = std::make_shared<Edge>(CARET_EDGE, tree->loc);
+  // Edge *edge = new Edge(CARET_EDGE, node.loc);
+  auto edge = std::make_shared<Edge>(CARET_EDGE, node.loc);
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
 
-NFA NFA::build_nfa_dollar(const std::shared_ptr<ParseNode> &tree) {
+NFA NFA::build_nfa_dollar(const ParseNode &node) {
   NFA nfa(2, 0, 1); // size = 2, initial = 0 , final = 1
-  // Edge *edge = new Edge(DOLLAR_EDGE, tree->loc);
-  nfa.add_edge(0, 1, std::make_shared<Edge>(DOLLAR_EDGE, tree->loc));
+  // Edge *edge = new Edge(DOLLAR_EDGE, node.loc);
+  nfa.add_edge(0, 1, std::make_shared<Edge>(DOLLAR_EDGE, node.loc));
   return nfa;
 }
 
-NFA NFA::build_nfa_char_set(const std::shared_ptr<ParseNode> &tree) {
+NFA NFA::build_nfa_char_set(const ParseNode &node) {
   NFA nfa(2, 0, 1); // size = 2, initial = 0, final = 1
-  // Edge *edge = new Edge(CHAR_SET_EDGE, tree->loc, tree->char_set);
-  auto edge = std::make_shared<Edge>(CHAR_SET_EDGE, tree->loc, tree->char_set);
+  // Edge *edge = new Edge(CHAR_SET_EDGE, node.loc, node.char_set);
+  auto edge = std::make_shared<Edge>(CHAR_SET_EDGE, node.loc, node.char_set);
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
 
-NFA NFA::build_nfa_ignored(const std::shared_ptr<ParseNode> &tree) {
+NFA NFA::build_nfa_ignored(const ParseNode &node) {
   NFA nfa(2, 0, 1); // size = 2, initial = 0 , final = 1
   nfa.add_edge(0, 1, Edge::make_epsilon());
   return nfa;
 }
 
-NFA NFA::build_nfa_backreference(const std::shared_ptr<ParseNode> &tree) {
+NFA NFA::build_nfa_backreference(const ParseNode &node) {
   NFA nfa(2, 0, 1); // size = 2, initial = 0, final = 1
-  // Edge *edge = new Edge(BACKREFERENCE_EDGE, tree->loc, tree->backref);
-  auto edge = std::make_shared<Edge>(BACKREFERENCE_EDGE, tree->loc, tree->backref);
+  // Edge *edge = new Edge(BACKREFERENCE_EDGE, node.loc, node.backref);
+  auto edge = std::make_shared<Edge>(BACKREFERENCE_EDGE, node.loc, node.backref);
   nfa.add_edge(0, 1, edge);
   return nfa;
 }
@@ -261,7 +492,20 @@ void NFA::add_edge(unsigned int from, unsigned int to, const std::shared_ptr<Edg
   assert(from < size);
   assert(to < size);
 
-  edge_table[from][to] = edge;
+  EdgeList &edges = edge_table[from];
+  auto it = std::lower_bound(edges.begin(), edges.end(), to, target_before);
+  if (it != edges.end() && it->first == to)
+    it->second = edge;
+  else
+    edges.insert(it, std::make_pair(to, edge));
+}
+
+std::shared_ptr<Edge> NFA::get_edge(unsigned int from, unsigned int to) const {
+  const EdgeList &edges = edge_table[from];
+  auto it = std::lower_bound(edges.begin(), edges.end(), to, target_before);
+  if (it != edges.end() && it->first == to)
+    return it->second;
+  return nullptr;
 }
 
 NFA NFA::concat_nfa(const NFA& nfa1, NFA nfa2) {
@@ -294,102 +538,241 @@ void NFA::shift_states(unsigned int shift) {
     return;
 
   // create a new, empty edge table (of the new size)
-  std::vector<std::shared_ptr<Edge>> empty_row(new_size);
-  std::vector<std::vector<std::shared_ptr<Edge>>> new_edge_table(new_size, empty_row);
+  std::vector<EdgeList> new_edge_table(new_size);
 
-  // copy all the edges to the new table, at their new locations
+  // move all the edges to the new table, at their new locations
   for (unsigned int i = 0; i < size; i++) {
-    for (unsigned int j = 0; j < size; j++) {
-      new_edge_table[i + shift][j + shift] = edge_table[i][j];
-    }
+    new_edge_table[i + shift].swap(edge_table[i]);
+    for (auto &target : new_edge_table[i + shift])
+      target.first += shift;
   }
 
   // update the NFA members
   size = new_size;
   initial += shift;
   final += shift;
-  edge_table = new_edge_table;
+  edge_table.swap(new_edge_table);
 }
 
 // fills states from other's states
 // (requires the use of shift_states first)
 void NFA::fill_states(const NFA &other) {
   for (unsigned int i = 0; i < other.size; i++) {
-    for (unsigned int j = 0; j < other.size; j++) {
-      edge_table[i][j] = other.edge_table[i][j];
+    // keep the edges to states past other's states
+    EdgeList edges = other.edge_table[i];
+    for (const auto &target : edge_table[i]) {
+      if (target.first >= other.size)
+        edges.push_back(target);
     }
+    edge_table[i].swap(edges);
   }
 }
 
 void NFA::append_empty_state() {
-  // append a new row (already with a larger size)
-  std::vector<std::shared_ptr<Edge>> empty_row(size + 1);
-  edge_table.push_back(empty_row);
+  edge_table.emplace_back();
+  size += 1;
+}
+
+void NFA::optimize() {
+  std::vector<bool> removed(size, false);
+  if (eliminate_epsilons(removed) > 0)
+    compact_states(removed);
+}
 
-  // append a new column
-  for (unsigned int i = 0; i < size; i++)
-    edge_table[i].emplace_back();
+// An epsilon edge from -> to is eliminated when it is the only edge leaving
+// from and the only edge entering to. The two states are merged into from,
+// which takes over the edges leaving to. Since every path through one of the
+// states also passes through the other, basis path traversal (which depends
+// on visited states and the order of the successor states) is unaffected.
+// Epsilon edges for alternations are branch or join points and are kept.
+unsigned int NFA::eliminate_epsilons(std::vector<bool> &removed) {
+  std::vector<unsigned int> in_degree(size, 0);
+  std::vector<unsigned int> out_degree(size, 0);
+  for (unsigned int from = 0; from < size; from++) {
+    out_degree[from] = edge_table[from].size();
+    for (const auto &target : edge_table[from])
+      in_degree[target.first]++;
+  }
 
-  size += 1;
+  unsigned int num_removed = 0;
+  for (unsigned int from = 0; from < size; from++) {
+    if (removed[from])
+      continue;
+
+    // keep merging while the state has a single epsilon edge leaving it
+    bool merged = true;
+    while (merged && out_degree[from] == 1) {
+      merged = false;
+      unsigned int to = edge_table[from][0].first;
+      auto edge = edge_table[from][0].second;
+      if (edge->get_type() == EPSILON_EDGE && in_degree[to] == 1) {
+        edge_table[from].swap(edge_table[to]);
+        edge_table[to].clear();
+        out_degree[from] = out_degree[to];
+        out_degree[to] = 0;
+        in_degree[to] = 0;
+        removed[to] = true;
+        if (final == to)
+          final = from;
+        num_removed++;
+        merged = true;
+      }
+    }
+  }
+
+  return num_removed;
+}
+
+void NFA::compact_states(const std::vector<bool> &removed) {
+  // map old states to new states
+  std::vector<unsigned int> new_state(size, 0);
+  unsigned int new_size = 0;
+  for (unsigned int i = 0; i < size; i++) {
+    if (!removed[i]) {
+      new_state[i] = new_size;
+      new_size++;
+    }
+  }
+
+  // copy the remaining edges to a new edge table
+  std::vector<EdgeList> new_edge_table(new_size);
+  for (unsigned int from = 0; from < size; from++) {
+    if (removed[from])
+      continue;
+    EdgeList &edges = new_edge_table[new_state[from]];
+    edges.swap(edge_table[from]);
+    for (auto &target : edges) {
+      assert(!removed[target.first]);
+      target.first = new_state[target.first];
+    }
+  }
+
+  // update the NFA members
+  size = new_size;
+  initial = new_state[initial];
+  final = new_state[final];
+  edge_table.swap(new_edge_table);
 }
 
-bool NFA::is_regex_string(const std::shared_ptr<ParseNode> &node, int repeat_lower, int repeat_upper) {
+bool NFA::is_regex_string(const ParseNode &node, int repeat_lower, int repeat_upper) {
   // Conditions for a string:
   // - Must be a repeated character set node
   // - Must be a * or + meaning that lower is 0 or 1, upper is -1 (no limit)
   // - Character set node must contain sufficient selections for a string
   //
-  if (node->type != CHAR_SET_NODE)
+  if (node.type != CHAR_SET_NODE)
     return false;
   if (repeat_upper != -1)
     return false;
   if (repeat_lower != 0 && repeat_lower != 1)
     return false;
-  if (!(node->char_set->is_string_candidate()))
+  if (!(node.char_set->is_string_candidate()))
     return false;
 
   return true;
 }
 
-std::vector<Path> NFA::find_basis_paths() {
-  Path path(initial);
-  std::vector<Path> paths;
-  bool *visited = new bool[size];
-  for (unsigned int i = 0; i < size; i++)
-    visited[i] = false;
+void NFA::reset() {
+  for (const EdgeList &edges : edge_table) {
+    for (const auto &target : edges)
+      target.second->reset();
+  }
+}
 
-  traverse(initial, path, paths, visited);
+std::vector<Path> NFA::find_basis_paths(unsigned int max_threads) {
+  // small searches are not worth starting threads for
+  unsigned int num_threads = 1;
+  if (max_threads > 1 &&
+      estimate_basis_paths().total_length >= PARALLEL_PATH_LENGTH)
+    num_threads = max_threads;
 
-  delete[] visited;
+  PathSearch search(*this);
+  std::vector<Path> paths = search.find_paths(num_threads);
+
+  // the first path through an edge creates its evil strings
+  std::unordered_set<const Edge *> seen;
+  for (Path &p : paths)
+    p.set_first_visits(seen);
 
   return paths;
 }
 
-void NFA::traverse(unsigned int curr_state, Path path, std::vector<Path> &paths,
-                   bool *visited) {
-  // stop if you already have been here
-  bool been_here = visited[curr_state];
-
-  // final state --> process the path and stop the traversal
-  if (curr_state == final) {
-    path.mark_path_visited(visited);
-    paths.push_back(path);
-    return;
+// The NFA is acyclic and every state reaches the final state, so a state
+// becomes visited as soon as the search enters it: the first path leaving the
+// state is completed (and marked) before the state can be entered again.
+// Revisited states contribute one path that follows the first edges to the
+// final state. This mirrors PathSearch without building any paths.
+PathEstimate NFA::estimate_basis_paths() {
+  std::vector<std::vector<unsigned int>> next_states(size);
+  for (unsigned int from = 0; from < size; from++) {
+    for (const auto &target : edge_table[from])
+      next_states[from].push_back(target.first);
   }
 
-  // for each adjacent state, find all paths
-  for (unsigned int next_state = 0; next_state < size; next_state++) {
-    auto edge = edge_table[curr_state][next_state];
-    if (!edge)
-      continue;
-    path.append(edge, next_state);
-    traverse(next_state, path, paths, visited);
-    path.remove_last();
-    if (been_here)
+  std::vector<bool> visited(size, false);
+  std::vector<unsigned long> first_lengths(size, 0);
+  PathEstimate path_estimate = {0, 0, 0};
+  estimate(next_states, visited, first_lengths, path_estimate);
+
+  return path_estimate;
+}
+
+void NFA::estimate(const std::vector<std::vector<unsigned int>> &next_states,
+                   std::vector<bool> &visited,
+                   std::vector<unsigned long> &first_lengths,
+                   PathEstimate &path_estimate) {
+  // states being expanded paired with the index of their next edge, the
+  // length of the path to a state is the number of states below it
+  std::vector<std::pair<unsigned int, unsigned int>> stack;
+  unsigned int curr_state = initial;
+  while (true) {
+    if (visited[curr_state] || curr_state == final) {
+      // revisited state --> one path following the first edges
+      visited[curr_state] = true;
+      unsigned long length =
+          stack.size() + first_length(curr_state, next_states, first_lengths);
+      path_estimate.paths++;
+      path_estimate.total_length += length;
+      if (length > path_estimate.max_length)
+        path_estimate.max_length = length;
+    } else {
+      visited[curr_state] = true;
+      stack.push_back(std::make_pair(curr_state, 0));
+    }
+
+    // move on to the next edge of the deepest state that has one left
+    while (!stack.empty() &&
+           stack.back().second == next_states[stack.back().first].size())
+      stack.pop_back();
+    if (stack.empty())
       break;
+    curr_state = next_states[stack.back().first][stack.back().second++];
   }
 }
 
+unsigned long
+NFA::first_length(unsigned int state,
+                  const std::vector<std::vector<unsigned int>> &next_states,
+                  std::vector<unsigned long> &first_lengths) {
+  // follow the first edges until reaching the final state or a state whose
+  // length is already known, then fill in the lengths on the way back
+  std::vector<unsigned int> chain;
+  unsigned int curr_state = state;
+  while (curr_state != final && first_lengths[curr_state] == 0) {
+    assert(!next_states[curr_state].empty());
+    chain.push_back(curr_state);
+    curr_state = next_states[curr_state][0];
+  }
+
+  unsigned long length = first_lengths[curr_state];
+  for (auto it = chain.rbegin(); it != chain.rend(); it++) {
+    length++;
+    first_lengths[*it] = length;
+  }
+
+  return first_lengths[state];
+}
+
 void NFA::print() {
   std::cout << "NFA: " << std::endl;
   std::cout << "Number of states: " << size << " ";
@@ -400,12 +783,9 @@ void NFA::print() {
   for (unsigned int from = 0; from < size; from++) {
     std::cout << "State " << from << ": ";
     std::cout << std::endl;
-    for (unsigned int to = 0; to < size; to++) {
-      auto edge = edge_table[from][to];
-      if (edge) {
-        std::cout << "  To state " << to << " on ";
-        edge->print();
-      }
+    for (const auto &target : edge_table[from]) {
+      std::cout << "  To state " << target.first << " on ";
+      target.second->print();
     }
   }
 
@@ -424,40 +804,38 @@ void NFA::add_stats(Stats &stats) {
   int backreference_count = 0;
   int epsilon_count = 0;
 
-  for (unsigned int from = 0; from < size; from++) {
-    for (unsigned int to = 0; to < size; to++) {
-      auto edge = edge_table[from][to];
-      if (edge) {
-        edge_count++;
-        switch (edge->get_type()) {
-        case CHARACTER_EDGE:
-          char_count++;
-          break;
-        case CHAR_SET_EDGE:
-          charset_count++;
-          break;
-        case STRING_EDGE:
-          string_count++;
-          break;
-        case BEGIN_LOOP_EDGE:
-          begin_loop_count++;
-          break;
-        case END_LOOP_EDGE:
-          end_loop_count++;
-          break;
-        case CARET_EDGE:
-          caret_count++;
-          break;
-        case DOLLAR_EDGE:
-          dollar_count++;
-          break;
-        case BACKREFERENCE_EDGE:
-          backreference_count++;
-          break;
-        case EPSILON_EDGE:
-          epsilon_count++;
-          break;
-        }
+  for (const EdgeList &edges : edge_table) {
+    for (const auto &target : edges) {
+      auto edge = target.second;
+      edge_count++;
+      switch (edge->get_type()) {
+      case CHARACTER_EDGE:
+        char_count++;
+        break;
+      case CHAR_SET_EDGE:
+        charset_count++;
+        break;
+      case STRING_EDGE:
+        string_count++;
+        break;
+      case BEGIN_LOOP_EDGE:
+        begin_loop_count++;
+        break;
+      case END_LOOP_EDGE:
+        end_loop_count++;
+        break;
+      case CARET_EDGE:
+        caret_count++;
+        break;
+      case DOLLAR_EDGE:
+        dollar_count++;
+        break;
+      case BACKREFERENCE_EDGE:
+        backreference_count++;
+        break;
+      case EPSILON_EDGE:
+        epsilon_count++;
+        break;
       }
     }
   }
@@ -473,4 +851,10 @@ void NFA::add_stats(Stats &stats) {
   stats.add("NFA", "NFA dollar edges", dollar_count);
   stats.add("NFA", "NFA backreference edges", backreference_count);
   stats.add("NFA", "NFA epsilon edges", epsilon_count);
+  stats.add("NFA", "NFA reused fragments", reused_fragments);
+
+  PathEstimate path_estimate = estimate_basis_paths();
+  stats.add("NFA", "Estimated paths", path_estimate.paths);
+  stats.add("NFA", "Estimated total path length", path_estimate.total_length);
+  stats.add("NFA", "Estimated max path length", path_estimate.max_length);
 }
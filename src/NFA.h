@@ -30,21 +30,63 @@
 #include "ParseTree.h"
 #include "Path.h"
 #include "Stats.h"
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+// Estimate of the basis paths produced by NFA::find_basis_paths
+struct PathEstimate {
+  unsigned long paths;        // number of basis paths
+  unsigned long total_length; // total number of edges over all paths
+  unsigned long max_length;   // number of edges in the longest path
+};
+
+// Smallest estimated total path length for the basis paths to be built on
+// several threads
+const unsigned long PARALLEL_PATH_LENGTH = 1000000;
+
+// NFA built for a subtree whose shape occurs more than once
+struct NFAFragment;
+
+// Edges leaving a state paired with the state they lead to, ordered by that
+// state
+typedef std::vector<std::pair<unsigned int, std::shared_ptr<Edge>>> EdgeList;
+
 class NFA {
 
 public:
   NFA() = default;
   NFA(unsigned int _size, unsigned int _initial, unsigned int _final);
   NFA(const NFA &other);
+  NFA(NFA &&other) = default;
   NFA &operator=(const NFA &other);
+  NFA &operator=(NFA &&other) = default;
+
+  // accessors
+  unsigned int get_size() const { return size; }
+  unsigned int get_initial() const { return initial; }
+  unsigned int get_final() const { return final; }
+  bool has_ignored_elements() const { return ignored_elements; }
+  std::shared_ptr<Edge> get_edge(unsigned int from, unsigned int to) const;
+  const EdgeList &get_edges(unsigned int from) const {
+    return edge_table[from];
+  }
 
   // build an NFA from the parse tree
   void build(ParseTree &tree);
 
-  // create a set of basis paths
-  std::vector<Path> find_basis_paths();
+  // removes epsilon chains and renumbers the remaining states
+  void optimize();
+
+  // clears the state set on the edges by processing paths
+  void reset();
+
+  // create a set of basis paths, large searches use up to max_threads threads
+  // to build the paths (the paths and their order are the same)
+  std::vector<Path> find_basis_paths(unsigned int max_threads = 1);
+
+  // determine the number and length of the basis paths without creating them
+  PathEstimate estimate_basis_paths();
 
   // print out the NFA
   void print();
@@ -56,43 +98,64 @@ private:
   unsigned int size;                           // number of states
   unsigned int initial;                        // initial state
   unsigned int final;                          // final state
-  std::vector<std::vector<std::shared_ptr<Edge>>> edge_table; // edge table
+  std::vector<EdgeList> edge_table;            // edges leaving each state
+  unsigned int reused_fragments = 0;           // fragments copied when built
+  bool ignored_elements = false; // \b, lookarounds, ... built as epsilons
 
-  // builds an NFA from tree
-  NFA build_nfa_from_tree(const std::shared_ptr<ParseNode>& tree);
+  // collects the subtrees whose NFAs are needed to build the node
+  void get_child_nodes(const std::vector<ParseNode> &nodes, int index,
+                       std::vector<int> &children);
 
-  // builds an alternation of nfa1 and nfa2 (nfa1|nfa2)
-  NFA build_nfa_alternation(const std::shared_ptr<ParseNode> &tree);
+  // builds an NFA for the tree node from the NFAs of its subtrees
+  NFA build_nfa_node(const std::vector<ParseNode> &nodes, int index,
+                     std::vector<NFA> &built);
+
+  // copies a fragment for an identical subtree
+  NFA instantiate_fragment(const std::vector<ParseNode> &nodes,
+                           const NFAFragment &fragment, int index);
+
+  // builds an alternation of nfa1, nfa2, ... (nfa1|nfa2|...)
+  NFA build_nfa_alternation(const std::vector<ParseNode> &nodes, int index,
+                            std::vector<NFA> &built);
+
+  // collects the alternatives along the right spine of an alternation
+  void get_alternatives(const std::vector<ParseNode> &nodes, int index,
+                        std::vector<int> &alts);
+
+  // collects the character nodes if the node is a literal string
+  bool get_literal_chars(const std::vector<ParseNode> &nodes, int index,
+                         std::vector<int> &chars);
 
   // builds a concatenation of nfa1 and nfa2 (nfa1nfa2)
-  NFA build_nfa_concat(const std::shared_ptr<ParseNode> &tree);
+  NFA build_nfa_concat(const ParseNode &node, std::vector<NFA> &built);
 
   // builds nfa{m,n}
-  NFA build_nfa_repeat(const std::shared_ptr<ParseNode> &tree);
+  NFA build_nfa_repeat(const std::vector<ParseNode> &nodes,
+                       const ParseNode &node, std::vector<NFA> &built);
 
   // builds special node for regex strings such as .+ or \w*
-  NFA build_nfa_string(const std::shared_ptr<ParseNode> &tree);
+  NFA build_nfa_string(const ParseNode &node, const ParseNode &child);
 
   // builds (nfa)
-  NFA build_nfa_group(const std::shared_ptr<ParseNode> &tree);
+  NFA build_nfa_group(const ParseNode &node, std::vector<NFA> &built);
 
   // builds nfa with character
-  NFA build_nfa_character(const std::shared_ptr<ParseNode> &tree);
+  NFA build_nfa_character(const ParseNode &node);
 
   // builds nfa with caret
-  NFA build_nfa_caret(const std::shared_ptr<ParseNode> &tree);
+  NFA build_nfa_caret(const ParseNode &node);
 
   // builds nfa with dollar
-  NFA build_nfa_dollar(const std::shared_ptr<ParseNode> &tree);
+  NFA build_nfa_dollar(const ParseNode &node);
 
   // builds nfa with char set as input
-  NFA build_nfa_char_set(const std::shared_ptr<ParseNode> &tree);
+  NFA build_nfa_char_set(const ParseNode &node);
 
   // builds nfa with ignored element
-  NFA build_nfa_ignored(const std::shared_ptr<ParseNode> &tree);
+  NFA build_nfa_ignored(const ParseNode &node);
 
   // builds nfa with backreference
-  NFA build_nfa_backreference(const std::shared_ptr<ParseNode> &tree);
+  NFA build_nfa_backreference(const ParseNode &node);
 
   // adds an edge to edge table
   void add_edge(unsigned int from, unsigned int to, const std::shared_ptr<Edge> &edge);
@@ -110,12 +173,26 @@ private:
   // appends a new empty state to the NFA
   void append_empty_state();
 
-  // returns true if repeat quantifier represents a string
-  bool is_regex_string(const std::shared_ptr<ParseNode> &node, int repeat_lower, int repeat_upper);
+  // merges states joined by epsilon edges that are neither branch nor join
+  // points, returns number of states removed
+  unsigned int eliminate_epsilons(std::vector<bool> &removed);
+
+  // renumbers the states that were not removed, keeping their relative order
+  void compact_states(const std::vector<bool> &removed);
 
-  // utility function to find all paths through the NFA
-  void traverse(unsigned int curr_state, Path path, std::vector<Path> &paths,
-                bool *visited);
+  // returns true if repeat quantifier represents a string
+  bool is_regex_string(const ParseNode &node, int repeat_lower, int repeat_upper);
+
+  // utility function to count the paths found by find_basis_paths
+  void estimate(const std::vector<std::vector<unsigned int>> &next_states,
+                std::vector<bool> &visited,
+                std::vector<unsigned long> &first_lengths,
+                PathEstimate &path_estimate);
+
+  // length of the path following the first edge out of each state
+  unsigned long first_length(unsigned int state,
+                             const std::vector<std::vector<unsigned int>> &next_states,
+                             std::vector<unsigned long> &first_lengths);
 };
 
 #endif // NFA_H
@@ -1,4 +1,4 @@
-/*  ParseTree.cpp: recursive descent parser
+/*  ParseTree.cpp: regex parser
 
     Copyright (C) 2016-2018  Eric Larson and Anna Kirk
     elarson@seattleu.edu
@@ -24,24 +24,28 @@
 
 #include "ParseTree.h"
 #include "Backref.h"
+#include "CharClass.h"
 #include "CharSet.h"
 #include "Scanner.h"
 #include "Stats.h"
 #include "Util.h"
+#include <algorithm>
 #include <iostream>
 #include <set>
 #include <sstream>
 #include <string>
 
 //=============================================================
-// RD Parser
+// Parser
 //=============================================================
 
 void ParseTree::build(Scanner &_scanner) {
   group_count = 1;
+  simplified_nodes = 0;
+  nodes.clear();
 
   scanner = _scanner;
-  root = expr();
+  int root = parse();
 
   if (scanner.get_type() != ERR) {
     std::stringstream s;
@@ -50,75 +54,172 @@ void ParseTree::build(Scanner &_scanner) {
     throw EgretException(s.str());
   }
   // count_groups();
+
+  tree_stats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  gather_stats(root);
+  simplify(root);
+  set_subtree_bounds();
+
+  // number the subtrees so identical subexpressions can share work
+  assign_shapes();
+
+  // split the alphabet by the character sets, literals and punctuation marks
+  std::set<char> chars = literals;
+  chars.insert(punct_marks.begin(), punct_marks.end());
+  char_sets.partition_alphabet(chars);
+}
+
+int ParseTree::add_node(ParseNode node) {
+  nodes.push_back(std::move(node));
+  return nodes.size() - 1;
 }
 
+// Parses the grammar with an explicit stack holding the expression of each
+// open group, so deeply nested regexes do not exhaust the call stack. Each
+// node is added once its children are complete, giving a post-order array.
+//
 // expr ::= concat '|' expr
 //	|   concat '|'
 //	|   '|' expr
 //	|   '|'
 //      |   concat
 //
-std::shared_ptr<ParseNode> ParseTree::expr() {
-  std::shared_ptr<ParseNode> left, right;
+// concat ::= rep concat
+//        |   rep
+//
+// atom	::= group
+// 	|   character
+//	|   char_class
+// 	|   char_set
+//
+int ParseTree::parse() {
+  std::vector<ParseFrame> frames(1);
+  frames.back().is_group = false;
+
+  int atom_node = -1;
+  bool atom_done = false;
 
   // check for alternation without a "left"
-  if (scanner.get_type() != ALTERNATION) {
-    left = concat();
-  }
+  bool parse_atom = scanner.get_type() != ALTERNATION;
+
+  while (true) {
+    if (parse_atom && !atom_done) {
+      // check for group
+      if (scanner.get_type() == LEFT_PAREN) {
+        open_group(frames);
+        if (!frames.back().ignored_group ||
+            scanner.get_type() != RIGHT_PAREN) {
+          // parse the group expression
+          parse_atom = scanner.get_type() != ALTERNATION;
+          continue;
+        }
+        atom_node = close_group(frames.back(), -1);
+        frames.pop_back();
+      }
 
-  // check for lack of alternation
-  if (scanner.get_type() != ALTERNATION) {
-    return left;
-  }
+      // check for character set
+      else if (scanner.get_type() == LEFT_BRACKET) {
+        atom_node = char_set();
+      }
 
-  // advance past alternation token
-  Location loc = scanner.get_loc();
-  scanner.advance();
+      // check for character class
+      else if (scanner.get_type() == CHAR_CLASS) {
+        atom_node = char_class();
+      }
 
-  // check for lacking right
-  if (!(scanner.get_type() == RIGHT_PAREN || scanner.get_type() == ERR)) {
-    right = expr();
-  }
+      // otherwise atom node is character
+      else {
+        atom_node = character();
+      }
+      atom_done = true;
+    }
 
-  // check for empty alternation clauses
-  // both empty: abort with an error
-  if (!left && !right) {
-    throw EgretException(
-        "ERROR (pointless alternation): both clauses are empty");
-  }
-  // left empty: return right?
-  else if (!left) {
-    // ParseNode *expr_node = new ParseNode(REPEAT_NODE, loc, right, 0, 1);
-    return std::make_shared<ParseNode>(REPEAT_NODE, loc, std::move(right), 0, 1);
-  }
-  // right empty: return left?
-  else if (!right) {
-    // ParseNode *expr_node = new ParseNode(REPEAT_NODE, loc, left, 0, 1);
-    return std::make_shared<ParseNode>(REPEAT_NODE, loc, std::move(left), 0, 1);
+    ParseFrame &frame = frames.back();
+    if (atom_done) {
+      atom_done = false;
+      frame.reps.push_back(rep(atom_node));
+
+      // check for concatenation
+      if (scanner.is_concat()) {
+        parse_atom = true;
+        continue;
+      }
+      frame.alts.push_back(concat(frame.reps));
+      frame.reps.clear();
+    } else {
+      // empty alternative before a '|'
+      frame.alts.push_back(-1);
+    }
+
+    // advance past alternation tokens
+    parse_atom = false;
+    while (scanner.get_type() == ALTERNATION) {
+      frame.bars.push_back(scanner.get_loc());
+      scanner.advance();
+
+      // check for lacking right
+      if (scanner.get_type() == RIGHT_PAREN || scanner.get_type() == ERR) {
+        frame.alts.push_back(-1);
+        break;
+      }
+      if (scanner.get_type() != ALTERNATION) {
+        parse_atom = true;
+        break;
+      }
+      frame.alts.push_back(-1);
+    }
+    if (parse_atom)
+      continue;
+
+    // end of the expression
+    int expr_node = expr(frame);
+    if (!frame.is_group)
+      return expr_node;
+    atom_node = close_group(frame, expr_node);
+    frames.pop_back();
+    atom_done = true;
   }
+}
 
-  // otherwise return left | right
-  // ParseNode *expr_node = new ParseNode(ALTERNATION_NODE, loc, left, right);
-  return std::make_shared<ParseNode>(ALTERNATION_NODE, loc, std::move(left), std::move(right));
+// Combines the alternatives of an expression from the right:
+// a | b | c => a | (b | c)
+int ParseTree::expr(ParseFrame &frame) {
+  int right = frame.alts.back();
+  for (int i = (int)frame.alts.size() - 2; i >= 0; i--) {
+    int left = frame.alts[i];
+    Location loc = frame.bars[i];
+
+    // check for empty alternation clauses
+    // both empty: abort with an error
+    if (left == -1 && right == -1) {
+      throw EgretException(
+          "ERROR (pointless alternation): both clauses are empty");
+    }
+    // left empty: return right?
+    else if (left == -1) {
+      right = add_node(ParseNode(REPEAT_NODE, loc, right, 0, 1));
+    }
+    // right empty: return left?
+    else if (right == -1) {
+      right = add_node(ParseNode(REPEAT_NODE, loc, left, 0, 1));
+    }
+    // otherwise return left | right
+    else {
+      right = add_node(ParseNode(ALTERNATION_NODE, loc, left, right));
+    }
+  }
+  return right;
 }
 
-// concat ::= rep concat
-//        |   rep
-//
-std::shared_ptr<ParseNode> ParseTree::concat() {
-  // always a repetition node to the left
-  auto left = rep();
-
-  // check for concatenation
-  if (scanner.is_concat()) {
-    auto right = concat();
-    int left_loc = left->loc.second;
+// Combines the repetitions of a concatenation from the right
+int ParseTree::concat(std::vector<int> &reps) {
+  int right = reps.back();
+  for (int i = (int)reps.size() - 2; i >= 0; i--) {
+    int left_loc = nodes[reps[i]].loc.second;
     Location loc = std::make_pair(left_loc, left_loc + 1);
-    // ParseNode *concat_node = new ParseNode(CONCAT_NODE, loc, left, right);
-    return std::make_shared<ParseNode>(CONCAT_NODE, loc, std::move(left), std::move(right));
-  } else {
-    return left;
+    right = add_node(ParseNode(CONCAT_NODE, loc, reps[i], right));
   }
+  return right;
 }
 
 // rep  ::= atom '*'
@@ -128,78 +229,41 @@ std::shared_ptr<ParseNode> ParseTree::concat() {
 //      |   atom '{n,}'
 //      |   atom
 //
-std::shared_ptr<ParseNode> ParseTree::rep() {
-  // first is always atom node
-  auto atom_node = atom();
+int ParseTree::rep(int atom_node) {
   Location loc = scanner.get_loc();
 
-  // then check for repetition character
+  // check for repetition character
   if (scanner.get_type() == STAR) {
     scanner.advance();
-    // ParseNode *rep_node = new ParseNode(REPEAT_NODE, loc, atom_node, 0, -1);
-    return std::make_shared<ParseNode>(REPEAT_NODE, loc, std::move(atom_node), 0, -1);
+    return add_node(ParseNode(REPEAT_NODE, loc, atom_node, 0, -1));
   } else if (scanner.get_type() == PLUS) {
     scanner.advance();
-    // ParseNode *rep_node = new ParseNode(REPEAT_NODE, loc, atom_node, 1, -1);
-    return std::make_shared<ParseNode>(REPEAT_NODE, loc, std::move(atom_node), 1, -1);
+    return add_node(ParseNode(REPEAT_NODE, loc, atom_node, 1, -1));
   } else if (scanner.get_type() == QUESTION) {
     scanner.advance();
-    // ParseNode *rep_node = new ParseNode(REPEAT_NODE, loc, atom_node, 0, 1);
-    return std::make_shared<ParseNode>(REPEAT_NODE, loc, std::move(atom_node), 0, 1);
+    return add_node(ParseNode(REPEAT_NODE, loc, atom_node, 0, 1));
   } else if (scanner.get_type() == REPEAT) {
     int lower = scanner.get_repeat_lower();
     int upper = scanner.get_repeat_upper();
     scanner.advance();
-    // ParseNode *rep_node =
-    //     new ParseNode(REPEAT_NODE, loc, atom_node, lower, upper);
-    return std::make_shared<ParseNode>(REPEAT_NODE, loc, std::move(atom_node), lower, upper);
+    return add_node(ParseNode(REPEAT_NODE, loc, atom_node, lower, upper));
   } else {
     return atom_node;
   }
 }
 
-// atom	::= group
-// 	|   character
-//	|   char_class
-// 	|   char_set
-//
-std::shared_ptr<ParseNode> ParseTree::atom() {
-  std::shared_ptr<ParseNode> atom_node;
-
-  // check for group
-  if (scanner.get_type() == LEFT_PAREN) {
-    atom_node = group();
-  }
-
-  // check for character set
-  else if (scanner.get_type() == LEFT_BRACKET) {
-    atom_node = char_set();
-  }
-
-  // check for character class
-  else if (scanner.get_type() == CHAR_CLASS) {
-    atom_node = char_class();
-  }
-
-  // otherwise atom node is character
-  else {
-    atom_node = character();
-  }
-
-  return atom_node;
-}
-
 // group ::= '(' expr ')'
 //       | '(' NO_GROUP_EXT expr ')'
 //       | '(' NAMED_GROUP_EXT expr ')'
 //       | '(' IGNORED_EXT expr ')'
 //       | '(' IGNORED_EXT ')'
 //
-std::shared_ptr<ParseNode> ParseTree::group() {
-  bool ignored_group = false;
-  bool normal_group = true;
-  std::string name;
-  int start_loc = scanner.get_loc().second;
+void ParseTree::open_group(std::vector<ParseFrame> &frames) {
+  ParseFrame frame;
+  frame.is_group = true;
+  frame.ignored_group = false;
+  frame.normal_group = true;
+  frame.start_loc = scanner.get_loc().second;
 
   if (scanner.get_type() != LEFT_PAREN) {
     std::stringstream s;
@@ -211,51 +275,52 @@ std::shared_ptr<ParseNode> ParseTree::group() {
 
   // Determine if it a special use of parentheses
   if (scanner.get_type() == NO_GROUP_EXT) {
-    normal_group = false;
+    frame.normal_group = false;
     scanner.advance();
   }
   if (scanner.get_type() == NAMED_GROUP_EXT) {
-    name = scanner.get_group_name();
+    frame.name = scanner.get_group_name();
     scanner.advance();
   }
   if (scanner.get_type() == IGNORED_EXT) {
-    normal_group = false;
-    ignored_group = true;
+    frame.normal_group = false;
+    frame.ignored_group = true;
     scanner.advance();
   }
 
   // Assign the group number now before advancing scanner
-  int group_num;
-  if (normal_group) {
-    group_num = group_count;
+  if (frame.normal_group) {
+    frame.group_num = group_count;
     group_count++;
   } else {
-    group_num = -1;
+    frame.group_num = -1;
   }
 
-  // Get the group expression
-  std::shared_ptr<ParseNode> left;
-  if (!ignored_group || scanner.get_type() != RIGHT_PAREN) {
-    left = expr();
-  }
+  frames.push_back(std::move(frame));
+}
 
+int ParseTree::close_group(ParseFrame &frame, int expr_node) {
   // Create the group node
-  std::shared_ptr<ParseNode> group_node;
+  int group_node;
   int end_loc = scanner.get_loc().first;
-  Location loc = std::make_pair(start_loc, end_loc);
-  if (ignored_group) {
-    // group_node = new ParseNode(IGNORED_NODE, loc, nullptr, nullptr);
-    group_node = std::make_shared<ParseNode>(IGNORED_NODE, loc, nullptr, nullptr);
+  Location loc = std::make_pair(frame.start_loc, end_loc);
+  if (frame.ignored_group) {
+    // the expression of an ignored group is left out of the tree
+    group_node = add_node(ParseNode(IGNORED_NODE, loc, -1, -1));
+  } else if (!frame.normal_group && frame.name.empty()) {
+    // non-capturing group: the group node would have no effect
+    group_node = expr_node;
+    simplified_nodes++;
   } else {
-    // group_node = new ParseNode(GROUP_NODE, loc, name, left, nullptr);
-    group_node = std::make_shared<ParseNode>(GROUP_NODE, loc, name, left, nullptr);
+    group_node =
+        add_node(ParseNode(GROUP_NODE, loc, frame.name, expr_node, -1));
   }
 
   // Store group information
-  if (normal_group) {
-    group_locs[group_num] = loc;
-    if (!name.empty()) {
-      named_group_locs[name] = loc;
+  if (frame.normal_group) {
+    group_locs[frame.group_num] = loc;
+    if (!frame.name.empty()) {
+      named_group_locs[frame.name] = loc;
     }
   }
 
@@ -276,40 +341,35 @@ std::shared_ptr<ParseNode> ParseTree::group() {
 //	     |	 '-'
 //	     |   WORD_BOUNDARY
 //
-std::shared_ptr<ParseNode> ParseTree::character() {
-  std::shared_ptr<ParseNode> character_node;
+int ParseTree::character() {
   Location loc = scanner.get_loc();
   TokenType type = scanner.get_type();
 
   if (type == CHARACTER) {
     char c = scanner.get_character();
     scanner.advance();
-    // character_node = new ParseNode(CHARACTER_NODE, loc, c);
-    character_node = std::make_shared<ParseNode>(CHARACTER_NODE, loc, c);
-    if (ispunct(c)) {
+    literals.insert(c);
+    if (is_punct_char(c)) {
       if (punct_marks.find(c) == punct_marks.end()) {
         punct_marks.insert(c);
       }
     }
+    return add_node(ParseNode(CHARACTER_NODE, loc, c));
   } else if (type == CARET) {
     scanner.advance();
-    // return new ParseNode(CARET_NODE, loc, NULL, NULL);
-    return std::make_shared<ParseNode>(CARET_NODE, loc, nullptr, nullptr);
+    return add_node(ParseNode(CARET_NODE, loc, -1, -1));
   } else if (type == DOLLAR) {
     scanner.advance();
-    // return new ParseNode(DOLLAR_NODE, loc, NULL, NULL);
-    return std::make_shared<ParseNode>(DOLLAR_NODE, loc, nullptr, nullptr);
+    return add_node(ParseNode(DOLLAR_NODE, loc, -1, -1));
   } else if (type == HYPHEN) {
     scanner.advance();
-    // character_node = new ParseNode(CHARACTER_NODE, loc, '-');
-    character_node = std::make_shared<ParseNode>(CHARACTER_NODE, loc, '-');
     if (punct_marks.find('-') == punct_marks.end()) {
       punct_marks.insert('-');
     }
+    return add_node(ParseNode(CHARACTER_NODE, loc, '-'));
   } else if (type == WORD_BOUNDARY) {
     scanner.advance();
-    // return new ParseNode(IGNORED_NODE, loc, nullptr, nullptr);
-    return std::make_shared<ParseNode>(IGNORED_NODE, loc, nullptr, nullptr);
+    return add_node(ParseNode(IGNORED_NODE, loc, -1, -1));
   } else if (type == BACKREFERENCE) {
     int group_num = scanner.get_group_num();
     std::string group_name = scanner.get_group_name();
@@ -320,45 +380,39 @@ std::shared_ptr<ParseNode> ParseTree::character() {
       group_loc = group_locs[group_num];
     }
 
-    // Backref *backref = new Backref(group_name, group_num, group_loc);
     auto backref = std::make_shared<Backref>(group_name, group_num, group_loc);
-    // character_node = new ParseNode(BACKREFERENCE_NODE, loc, backref);
-    character_node = std::make_shared<ParseNode>(BACKREFERENCE_NODE, loc, std::move(backref));
     scanner.advance();
+    return add_node(ParseNode(BACKREFERENCE_NODE, loc, std::move(backref)));
   } else {
     std::stringstream s;
     s << "ERROR (parse error): expected character type but received "
       << scanner.get_type_str();
     throw EgretException(s.str());
   }
-
-  return character_node;
 }
 
 // char_class ::= CHAR_CLASS
 //
-std::shared_ptr<ParseNode> ParseTree::char_class() {
+int ParseTree::char_class() {
   Location loc = scanner.get_loc();
   char c = scanner.get_character();
   scanner.advance();
 
-  // CharSet *char_set = new CharSet();
   auto char_set = std::make_shared<CharSet>();
 
   CharSetItem char_set_item {};
   char_set_item.type = CHAR_CLASS_ITEM;
   char_set_item.character = c;
   char_set->add_item(char_set_item);
+  char_set->intern(char_sets);
 
-  // ParseNode *char_set_node = new ParseNode(CHAR_SET_NODE, loc, char_set);
-  return std::make_shared<ParseNode>(CHAR_SET_NODE, loc, std::move(char_set));
+  return add_node(ParseNode(CHAR_SET_NODE, loc, std::move(char_set)));
 }
 
 // char_set ::= '[' char_list ']'
 // 	    |   '[' '^' char_list ']'
 //
-std::shared_ptr<ParseNode> ParseTree::char_set() {
-  std::shared_ptr<ParseNode> char_set_node;
+int ParseTree::char_set() {
   bool is_complement = false;
   int start_loc = scanner.get_loc().second;
 
@@ -375,16 +429,18 @@ std::shared_ptr<ParseNode> ParseTree::char_set() {
     scanner.advance();
   }
 
-  char_set_node = char_list(start_loc);
+  int char_set_node = char_list(start_loc);
+  ParseNode &node = nodes[char_set_node];
   if (is_complement)
-    char_set_node->char_set->set_complement(true);
-  if (char_set_node->char_set->is_single_char() && !is_complement) {
-    char c = char_set_node->char_set->get_valid_character();
-    char_set_node.reset();
+    node.char_set->set_complement(true);
+  if (node.char_set->is_single_char() && !is_complement) {
+    char c = node.char_set->get_valid_character();
+    literals.insert(c);
     int end_loc = scanner.get_loc().first;
     Location loc = std::make_pair(start_loc, end_loc);
-    // char_set_node = new ParseNode(CHARACTER_NODE, loc, c);
-    char_set_node = std::make_shared<ParseNode>(CHARACTER_NODE, loc, c);
+    node = ParseNode(CHARACTER_NODE, loc, c);
+  } else {
+    node.char_set->intern(char_sets);
   }
 
   if (scanner.get_type() != RIGHT_BRACKET) {
@@ -401,22 +457,24 @@ std::shared_ptr<ParseNode> ParseTree::char_set() {
 // char_list ::= list_item charlist
 // 	     |   list_item
 //
-std::shared_ptr<ParseNode> ParseTree::char_list(int start_loc) {
-  CharSetItem char_set_item = list_item();
-  std::shared_ptr<ParseNode> char_set_node;
+int ParseTree::char_list(int start_loc) {
+  std::vector<CharSetItem> items;
+  items.push_back(list_item());
 
   // Check for end of list
-  if (scanner.get_type() == RIGHT_BRACKET) {
-    int end_loc = scanner.get_loc().first;
-    Location loc = std::make_pair(start_loc, end_loc);
-    // char_set_node = new ParseNode(CHAR_SET_NODE, loc, new CharSet());
-    char_set_node = std::make_shared<ParseNode>(CHAR_SET_NODE, loc, std::make_shared<CharSet>());
-  } else {
-    char_set_node = char_list(start_loc);
+  while (scanner.get_type() != RIGHT_BRACKET) {
+    items.push_back(list_item());
   }
 
-  char_set_node->char_set->add_item(char_set_item);
-  return char_set_node;
+  int end_loc = scanner.get_loc().first;
+  Location loc = std::make_pair(start_loc, end_loc);
+  auto char_set = std::make_shared<CharSet>();
+
+  // the items are added last to first
+  for (auto it = items.rbegin(); it != items.rend(); ++it) {
+    char_set->add_item(*it);
+  }
+  return add_node(ParseNode(CHAR_SET_NODE, loc, std::move(char_set)));
 }
 
 // list_item ::= character_item
@@ -462,7 +520,7 @@ CharSetItem ParseTree::character_item() {
     throw EgretException(s.str());
   }
   char c = char_set_item.character;
-  if (ispunct(c)) {
+  if (is_punct_char(c)) {
     if (punct_marks.find(c) == punct_marks.end()) {
       punct_marks.insert(c);
     }
@@ -518,72 +576,293 @@ CharSetItem ParseTree::char_range_item() {
   return char_set_item;
 }
 
+//=============================================================
+// Simplification
+//=============================================================
+
+// Rewrites that keep the matched language and the locations used by alerts:
+// - {1} repeats are replaced by the repeated node
+// - alternations of distinct letters and digits become a character set
+//   spanning the alternatives (a|b|c => [abc]). The set is tested with the
+//   alternatives only, so the test strings are the same. Punctuation is left
+//   alone since the character set checks would treat it differently, and an
+//   alternation with a repeated or other alternative is kept whole.
+// Nested quantifiers such as (a*)* are kept since the backtracking check
+// needs to see them.
+// The nodes are copied into a new array, which also drops the nodes of
+// ignored groups that are not part of the tree.
+void ParseTree::simplify(int root) {
+  // find the nodes reachable from the root, top down
+  std::vector<bool> keep(nodes.size(), false);
+  std::vector<bool> collapse(nodes.size(), false);
+  std::vector<bool> rejected(nodes.size(), false);
+  keep[root] = true;
+  for (int i = root; i >= 0; i--) {
+    if (!keep[i])
+      continue;
+    const ParseNode &node = nodes[i];
+    std::vector<int> alts;
+    if (node.type == ALTERNATION_NODE && !rejected[i]) {
+      if (get_single_char_alternatives(i, alts)) {
+        collapse[i] = true;
+        continue;
+      }
+
+      // the rest of the chain belongs to the same alternation (a|b|a), so
+      // it is not collapsed on its own
+      for (int alt = node.right;
+           alt != -1 && nodes[alt].type == ALTERNATION_NODE;
+           alt = nodes[alt].right)
+        rejected[alt] = true;
+    }
+    if (node.left != -1)
+      keep[node.left] = true;
+    if (node.right != -1)
+      keep[node.right] = true;
+  }
+
+  // copy the kept nodes bottom up
+  std::vector<ParseNode> new_nodes;
+  std::vector<int> new_index(nodes.size(), -1);
+  for (int i = 0; i <= root; i++) {
+    if (!keep[i])
+      continue;
+
+    if (collapse[i]) {
+      std::vector<int> alts;
+      get_single_char_alternatives(i, alts);
+      auto char_set = std::make_shared<CharSet>();
+      char_set->set_alternation(true);
+      for (int alt : alts) {
+        CharSetItem char_set_item {};
+        char_set_item.type = CHARACTER_ITEM;
+        char_set_item.character = nodes[alt].character;
+        char_set->add_item(char_set_item);
+      }
+      char_set->intern(char_sets);
+      Location loc = std::make_pair(nodes[alts.front()].loc.first,
+                                    nodes[alts.back()].loc.second);
+      simplified_nodes += 2 * alts.size() - 2;
+      new_nodes.push_back(ParseNode(CHAR_SET_NODE, loc, std::move(char_set)));
+      new_index[i] = new_nodes.size() - 1;
+      continue;
+    }
+
+    ParseNode &node = nodes[i];
+    if (node.left != -1)
+      node.left = new_index[node.left];
+    if (node.right != -1)
+      node.right = new_index[node.right];
+
+    if (node.type == REPEAT_NODE && node.repeat_lower == 1 &&
+        node.repeat_upper == 1) {
+      simplified_nodes++;
+      new_index[i] = node.left;
+      continue;
+    }
+
+    new_nodes.push_back(std::move(node));
+    new_index[i] = new_nodes.size() - 1;
+  }
+  nodes.swap(new_nodes);
+}
+
+bool ParseTree::get_single_char_alternatives(int node,
+                                             std::vector<int> &alts) {
+  std::set<char> seen;
+  int curr = node;
+  while (curr != -1) {
+    int alt = curr;
+    if (nodes[curr].type == ALTERNATION_NODE) {
+      alt = nodes[curr].left;
+      curr = nodes[curr].right;
+    } else {
+      curr = -1;
+    }
+    if (nodes[alt].type != CHARACTER_NODE)
+      return false;
+    char c = nodes[alt].character;
+    if (!(is_lower_char(c) || is_upper_char(c) || is_digit_char(c)))
+      return false;
+    if (!seen.insert(c).second)
+      return false;
+    alts.push_back(alt);
+  }
+  return true;
+}
+
+void ParseTree::set_subtree_bounds() {
+  for (unsigned int i = 0; i < nodes.size(); i++) {
+    ParseNode &node = nodes[i];
+    if (node.left != -1)
+      node.first = nodes[node.left].first;
+    else if (node.right != -1)
+      node.first = nodes[node.right].first;
+    else
+      node.first = i;
+  }
+}
+
+//=============================================================
+// Hash-consing
+//=============================================================
+
+std::map<int, Location> ParseTree::get_repeat_spans() const {
+  std::map<int, Location> spans;
+
+  // leftmost location of each subtree
+  std::vector<int> starts(nodes.size());
+  for (unsigned int i = 0; i < nodes.size(); i++) {
+    const ParseNode &node = nodes[i];
+    int start = node.loc.first;
+    if (node.left != -1)
+      start = std::min(start, starts[node.left]);
+    if (node.right != -1)
+      start = std::min(start, starts[node.right]);
+    starts[i] = start;
+
+    if (node.type == REPEAT_NODE)
+      spans[node.loc.first] = std::make_pair(start, node.loc.second);
+  }
+  return spans;
+}
+
+void ParseTree::assign_shapes() {
+  shapes.clear();
+  shape_counts.clear();
+
+  // leftmost location of each subtree
+  std::vector<int> starts(nodes.size());
+
+  for (unsigned int i = 0; i < nodes.size(); i++) {
+    ParseNode &node = nodes[i];
+    int start = node.loc.first;
+    if (node.left != -1)
+      start = std::min(start, starts[node.left]);
+    if (node.right != -1)
+      start = std::min(start, starts[node.right]);
+    starts[i] = start;
+
+    // a backreference refers to a particular group so it is never shared
+    if (node.type == BACKREFERENCE_NODE) {
+      node.shape = shape_counts.size();
+      shape_counts.push_back(1);
+      continue;
+    }
+
+    std::stringstream key;
+    key << node.type << " " << node.loc.first - start << " "
+        << node.loc.second - start;
+    if (node.left != -1)
+      key << " L" << nodes[node.left].shape << " "
+          << starts[node.left] - start;
+    if (node.right != -1)
+      key << " R" << nodes[node.right].shape << " "
+          << starts[node.right] - start;
+    switch (node.type) {
+    case CHARACTER_NODE:
+      key << " " << (int)node.character;
+      break;
+    case REPEAT_NODE:
+      key << " " << node.repeat_lower << " " << node.repeat_upper;
+      break;
+    case CHAR_SET_NODE:
+      key << " " << node.char_set->get_key();
+      break;
+    case GROUP_NODE:
+      key << " " << node.group_name;
+      break;
+    default:
+      break;
+    }
+
+    auto it = shapes.find(key.str());
+    if (it == shapes.end()) {
+      it = shapes.insert(std::make_pair(key.str(), shape_counts.size())).first;
+      shape_counts.push_back(0);
+    }
+    node.shape = it->second;
+    shape_counts[node.shape]++;
+  }
+
+  for (ParseNode &node : nodes)
+    node.shared = shape_counts[node.shape] > 1;
+}
+
 void ParseTree::print() {
   std::cout << "Tree:" << std::endl;
-  print_tree(root, 0);
+  print_tree();
   std::cout << std::endl;
 }
 
-void ParseTree::print_tree(const std::shared_ptr<ParseNode> &node, unsigned offset) {
-  if (!node)
-    return;
-
-  for (unsigned int i = 0; i < offset; i++)
-    std::cout << " ";
-
-  std::cout << "<";
-  switch (node->type) {
-  case ALTERNATION_NODE:
-    std::cout << "alternation |";
-    break;
-  case CONCAT_NODE:
-    std::cout << "concat";
-    break;
-  case REPEAT_NODE:
-    if (node->repeat_upper == -1)
-      std::cout << "repeat {" << node->repeat_lower << ",}";
-    else
-      std::cout << "repeat {" << node->repeat_lower << "," << node->repeat_upper
-                << "}";
-    break;
-  case GROUP_NODE:
-    std::cout << "group";
-    break;
-  case BACKREFERENCE_NODE:
-    std::cout << "backreference ";
-    node->backref->print();
-    break;
-  case IGNORED_NODE:
-    std::cout << "ignored";
-    break;
-  case CHARACTER_NODE:
-    std::cout << "character: " << node->character;
-    break;
-  case CARET_NODE:
-    std::cout << "caret ^";
-    break;
-  case DOLLAR_NODE:
-    std::cout << "dollar $";
-    break;
-  case CHAR_SET_NODE:
-    std::cout << "charset [";
-    node->char_set->print();
-    std::cout << "]";
-    break;
-  default:
-    assert(false);
-  }
-
-  std::cout << " @ (" << node->loc.first << "," << node->loc.second << ")>"
-            << std::endl;
-
-  print_tree(node->left, offset + 2);
-  print_tree(node->right, offset + 2);
+void ParseTree::print_tree() {
+  // nodes to print in pre-order with their indentation
+  std::vector<std::pair<int, unsigned int>> stack;
+  if (!nodes.empty())
+    stack.push_back(std::make_pair(get_root(), 0));
+
+  while (!stack.empty()) {
+    const ParseNode &node = nodes[stack.back().first];
+    unsigned int offset = stack.back().second;
+    stack.pop_back();
+
+    for (unsigned int i = 0; i < offset; i++)
+      std::cout << " ";
+
+    std::cout << "<";
+    switch (node.type) {
+    case ALTERNATION_NODE:
+      std::cout << "alternation |";
+      break;
+    case CONCAT_NODE:
+      std::cout << "concat";
+      break;
+    case REPEAT_NODE:
+      if (node.repeat_upper == -1)
+        std::cout << "repeat {" << node.repeat_lower << ",}";
+      else
+        std::cout << "repeat {" << node.repeat_lower << ","
+                  << node.repeat_upper << "}";
+      break;
+    case GROUP_NODE:
+      std::cout << "group";
+      break;
+    case BACKREFERENCE_NODE:
+      std::cout << "backreference ";
+      node.backref->print();
+      break;
+    case IGNORED_NODE:
+      std::cout << "ignored";
+      break;
+    case CHARACTER_NODE:
+      std::cout << "character: " << node.character;
+      break;
+    case CARET_NODE:
+      std::cout << "caret ^";
+      break;
+    case DOLLAR_NODE:
+      std::cout << "dollar $";
+      break;
+    case CHAR_SET_NODE:
+      std::cout << "charset [";
+      node.char_set->print();
+      std::cout << "]";
+      break;
+    default:
+      assert(false);
+    }
+
+    std::cout << " @ (" << node.loc.first << "," << node.loc.second << ")>"
+              << std::endl;
+
+    if (node.right != -1)
+      stack.push_back(std::make_pair(node.right, offset + 2));
+    if (node.left != -1)
+      stack.push_back(std::make_pair(node.left, offset + 2));
+  }
 }
 
 void ParseTree::add_stats(Stats &stats) {
-  ParseTreeStats tree_stats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-  gather_stats(root, tree_stats);
   stats.add("PARSE_TREE", "Alternation nodes", tree_stats.alternation_nodes);
   stats.add("PARSE_TREE", "Concat nodes", tree_stats.concat_nodes);
   stats.add("PARSE_TREE", "Repeat nodes", tree_stats.repeat_nodes);
@@ -600,53 +879,65 @@ void ParseTree::add_stats(Stats &stats) {
   stats.add("PARSE_TREE", "Character set nodes (^)",
             tree_stats.complement_char_set_nodes);
   stats.add("PARSE_TREE", "Ignored nodes", tree_stats.ignored_nodes);
+  stats.add("PARSE_TREE", "Simplified nodes", simplified_nodes);
+  stats.add("PARSE_TREE", "Distinct subtrees", shape_counts.size());
+  stats.add("PARSE_TREE", "Distinct character sets", char_sets.get_num_sets());
+  stats.add("PARSE_TREE", "Shared character sets",
+            char_sets.get_num_shared());
+  stats.add("PARSE_TREE", "Alphabet classes", char_sets.get_num_classes());
 }
 
-void ParseTree::gather_stats(const std::shared_ptr<ParseNode> &node, ParseTreeStats &tree_stats) {
-  if (!node)
-    return;
-
-  switch (node->type) {
-  case ALTERNATION_NODE:
-    tree_stats.alternation_nodes++;
-    break;
-  case CONCAT_NODE:
-    tree_stats.concat_nodes++;
-    break;
-  case REPEAT_NODE:
-    tree_stats.repeat_nodes++;
-    break;
-  case GROUP_NODE:
-    if (node->group_name.empty())
-      tree_stats.unnamed_group_nodes++;
-    else
-      tree_stats.named_group_nodes++;
-    break;
-  case BACKREFERENCE_NODE:
-    tree_stats.backreference_nodes++;
-    break;
-  case CHARACTER_NODE:
-    tree_stats.character_nodes++;
-    break;
-  case CARET_NODE:
-    tree_stats.caret_nodes++;
-    break;
-  case DOLLAR_NODE:
-    tree_stats.dollar_nodes++;
-    break;
-  case CHAR_SET_NODE:
-    if (node->char_set->is_complement())
-      tree_stats.complement_char_set_nodes++;
-    else
-      tree_stats.normal_char_set_nodes++;
-    break;
-  case IGNORED_NODE:
-    tree_stats.ignored_nodes++;
-    break;
-  default:
-    assert(false);
+void ParseTree::gather_stats(int root) {
+  // only the nodes reachable from the root, the nodes of ignored groups are
+  // not part of the tree
+  std::vector<int> stack(1, root);
+  while (!stack.empty()) {
+    const ParseNode &node = nodes[stack.back()];
+    stack.pop_back();
+    if (node.left != -1)
+      stack.push_back(node.left);
+    if (node.right != -1)
+      stack.push_back(node.right);
+
+    switch (node.type) {
+    case ALTERNATION_NODE:
+      tree_stats.alternation_nodes++;
+      break;
+    case CONCAT_NODE:
+      tree_stats.concat_nodes++;
+      break;
+    case REPEAT_NODE:
+      tree_stats.repeat_nodes++;
+      break;
+    case GROUP_NODE:
+      if (node.group_name.empty())
+        tree_stats.unnamed_group_nodes++;
+      else
+        tree_stats.named_group_nodes++;
+      break;
+    case BACKREFERENCE_NODE:
+      tree_stats.backreference_nodes++;
+      break;
+    case CHARACTER_NODE:
+      tree_stats.character_nodes++;
+      break;
+    case CARET_NODE:
+      tree_stats.caret_nodes++;
+      break;
+    case DOLLAR_NODE:
+      tree_stats.dollar_nodes++;
+      break;
+    case CHAR_SET_NODE:
+      if (node.char_set->is_complement())
+        tree_stats.complement_char_set_nodes++;
+      else
+        tree_stats.normal_char_set_nodes++;
+      break;
+    case IGNORED_NODE:
+      tree_stats.ignored_nodes++;
+      break;
+    default:
+      assert(false);
+    }
   }
-
-  gather_stats(node->left, tree_stats);
-  gather_stats(node->right, tree_stats);
 }
@@ -1,4 +1,4 @@
-/*  ParseTree.h: recursive descent parser
+/*  ParseTree.h: regex parser
 
     Copyright (C) 2016-2018  Eric Larson and Anna Kirk
     elarson@seattleu.edu
@@ -87,10 +87,13 @@
 #include "Scanner.h"
 #include "Stats.h"
 #include <cassert>
+#include <map>
 #include <set>
+#include <string>
 #include <unordered_map>
 #include <memory>
 #include <utility>
+#include <vector>
 
 typedef enum {
   ALTERNATION_NODE,
@@ -105,81 +108,109 @@ typedef enum {
   IGNORED_NODE
 } NodeType;
 
+// A node of the parse tree. The nodes are stored in post-order in one array
+// and refer to their children by index (-1 if there is no child), so the
+// nodes of a subtree are contiguous and end with the root of the subtree.
 struct ParseNode {
-  ParseNode(NodeType t, Location _loc, std::shared_ptr<ParseNode> l, std::shared_ptr<ParseNode> r)
+  ParseNode(NodeType t, Location _loc, int l, int r)
   : type(t)
   , loc(std::move(_loc))
-  , left(std::move(l))
-  , right(std::move(r))
+  , left(l)
+  , right(r)
+  , first(-1)
   , character(0)
   , repeat_lower(-1)
-  , repeat_upper(-1) {
+  , repeat_upper(-1)
+  , shape(-1)
+  , shared(false) {
   }
 
-  ParseNode(NodeType t, Location _loc, std::string _name, std::shared_ptr<ParseNode> l,
-            std::shared_ptr<ParseNode> r)
+  ParseNode(NodeType t, Location _loc, std::string _name, int l, int r)
   : type(t)
   , loc(std::move(_loc))
-  , left(std::move(l))
-  , right(std::move(r))
+  , left(l)
+  , right(r)
+  , first(-1)
   , character(0)
   , repeat_lower(-1)
   , repeat_upper(-1)
-  , group_name(std::move(_name)) {
+  , group_name(std::move(_name))
+  , shape(-1)
+  , shared(false) {
     assert(t == GROUP_NODE);
   }
 
   ParseNode(NodeType t, Location _loc, std::shared_ptr<CharSet> c)
   : type(t)
   , loc(std::move(_loc))
-  , left()
-  , right()
+  , left(-1)
+  , right(-1)
+  , first(-1)
   , character(0)
   , char_set(std::move(c))
   , repeat_lower(-1)
-  , repeat_upper(-1) {
+  , repeat_upper(-1)
+  , shape(-1)
+  , shared(false) {
     assert(t == CHAR_SET_NODE);
   }
 
   ParseNode(NodeType t, Location _loc, char c)
   : type(t)
   , loc(std::move(_loc))
+  , left(-1)
+  , right(-1)
+  , first(-1)
   , character(c)
   , repeat_lower(-1)
-  , repeat_upper(-1) {
+  , repeat_upper(-1)
+  , shape(-1)
+  , shared(false) {
     assert(t == CHARACTER_NODE);
   }
 
   ParseNode(NodeType t, Location _loc, std::shared_ptr<Backref> b)
   : type(t)
   , loc(std::move(_loc))
+  , left(-1)
+  , right(-1)
+  , first(-1)
   , character(0)
   , repeat_lower(-1)
   , repeat_upper(-1)
-  , backref(std::move(b)) {
+  , backref(std::move(b))
+  , shape(-1)
+  , shared(false) {
     assert(t == BACKREFERENCE_NODE);
   }
 
-  ParseNode(NodeType t, Location _loc, std::shared_ptr<ParseNode> l, int lower, int upper)
+  ParseNode(NodeType t, Location _loc, int l, int lower, int upper)
   : type(t)
   , loc(std::move(_loc))
-  , left(std::move(l))
+  , left(l)
+  , right(-1)
+  , first(-1)
   , character(0)
   , repeat_lower(lower)
-  , repeat_upper(upper) {
+  , repeat_upper(upper)
+  , shape(-1)
+  , shared(false) {
     assert(t == REPEAT_NODE);
   }
 
   NodeType type;
   Location loc;
-  std::shared_ptr<ParseNode> left;
-  std::shared_ptr<ParseNode> right;
+  int left;               // index of left child (-1 if none)
+  int right;              // index of right child (-1 if none)
+  int first;              // index of the first node of the subtree
   char character;         // For CHARACTER_NODE
   std::shared_ptr<CharSet> char_set;      // For CHAR_SET_NODE
   int repeat_lower;       // For REPEAT_NODE
   int repeat_upper;       // For REPEAT_NODE (-1 for no limit)
   std::shared_ptr<Backref> backref;       // For BACKREFERENCE_NODE
   std::string group_name; // For GROUP_NODE
+  int shape;              // same for subtrees with the same structure
+  bool shared;            // true if another subtree has the same shape
 };
 
 class ParseTree {
@@ -188,43 +219,85 @@ public:
   // build parse tree using regex stored in scanner
   void build(Scanner &_scanner);
 
-  // get root of the tree
-  std::shared_ptr<ParseNode> get_root() { return root; }
+  // get the nodes in post-order, the root is the last node
+  const std::vector<ParseNode> &get_nodes() const { return nodes; }
+
+  // get index of the root of the tree
+  int get_root() const { return nodes.size() - 1; }
 
   // get set of punctuation marks
   std::set<char> get_punct_marks() { return punct_marks; }
 
+  // get the location of each repeated subexpression, from the start of the
+  // repeated element to the end of its quantifier, keyed by the start of the
+  // quantifier
+  std::map<int, Location> get_repeat_spans() const;
+
   // prints the tree
   void print();
 
-  // get tree stats
+  // get tree stats, the node counts are of the tree before simplification
   void add_stats(Stats &stats);
 
 private:
-  std::shared_ptr<ParseNode> root;            // root of parse tree
+  std::vector<ParseNode> nodes; // nodes of the parse tree in post-order
   Scanner scanner;            // scanner
   std::set<char> punct_marks; // set of punctuation marks
+  std::set<char> literals;    // characters matched outside of char sets
+  CharSetPool char_sets;      // derived data shared by identical char sets
   std::unordered_map<int, Location> group_locs;
   std::unordered_map<std::string, Location> named_group_locs;
   int group_count;
+  int simplified_nodes;       // nodes removed or merged by simplification
+  std::map<std::string, int> shapes;  // structure of each shape
+  std::vector<unsigned int> shape_counts; // number of subtrees per shape
+
+  // An expression being parsed: the whole regex or the inside of a group
+  struct ParseFrame {
+    bool is_group;               // false for the whole regex
+    int start_loc;               // group: location after the (
+    bool normal_group;           // group: capturing group
+    bool ignored_group;          // group: ignored extension
+    std::string name;            // group: name of a named group
+    int group_num;               // group: number of a capturing group
+    std::vector<int> alts;       // alternatives (-1 if empty)
+    std::vector<Location> bars;  // location of the | before each alternative
+    std::vector<int> reps;       // repetitions in the current alternative
+  };
 
   // creation functions
-  std::shared_ptr<ParseNode> expr();
-  std::shared_ptr<ParseNode> concat();
-  std::shared_ptr<ParseNode> rep();
-  std::shared_ptr<ParseNode> atom();
-  std::shared_ptr<ParseNode> group();
-  std::shared_ptr<ParseNode> character();
-  std::shared_ptr<ParseNode> char_class();
-  std::shared_ptr<ParseNode> char_set();
-  std::shared_ptr<ParseNode> char_list(int start_loc);
+  int add_node(ParseNode node);
+  int parse();
+  void open_group(std::vector<ParseFrame> &frames);
+  int close_group(ParseFrame &frame, int expr_node);
+  int rep(int atom_node);
+  int concat(std::vector<int> &reps);
+  int expr(ParseFrame &frame);
+  int character();
+  int char_class();
+  int char_set();
+  int char_list(int start_loc);
   CharSetItem list_item();
   CharSetItem character_item();
   CharSetItem char_class_item();
   CharSetItem char_range_item();
 
+  // records the first node of each subtree
+  void set_subtree_bounds();
+
+  // rewrites the tree into a smaller equivalent tree
+  void simplify(int root);
+
+  // collects the alternatives of an alternation if they are all distinct
+  // letters or digits, returns false otherwise
+  bool get_single_char_alternatives(int node, std::vector<int> &alts);
+
+  // hash-conses the subtrees by structure and location relative to the start
+  // of the subtree
+  void assign_shapes();
+
   // print the tree
-  void print_tree(const std::shared_ptr<ParseNode> &node, unsigned offset);
+  void print_tree();
 
   // gather stats
   struct ParseTreeStats {
@@ -241,7 +314,10 @@ private:
     int complement_char_set_nodes;
     int ignored_nodes;
   };
-  void gather_stats(const std::shared_ptr<ParseNode> &node, ParseTreeStats &tree_stats);
+  ParseTreeStats tree_stats; // node counts before simplification
+
+  // counts the nodes of the tree as parsed, before simplification
+  void gather_stats(int root);
 };
 
 #endif // PARSE_TREE_H
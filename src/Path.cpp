@@ -21,6 +21,7 @@
 
 // TODO: Check proper set of include files
 #include "Path.h"
+#include "CharClass.h"
 #include "Edge.h"
 #include "Util.h"
 #include <set>
@@ -39,29 +40,82 @@ void Path::remove_last() {
   states.pop_back();
 }
 
-void Path::mark_path_visited(bool *visited) {
-  for (unsigned int & state : states) {
-    visited[state] = true;
+// PATH PROCESSING FUNCTION
+
+void Path::set_first_visits(std::unordered_set<const Edge *> &seen) {
+  first_visits.clear();
+  for (auto &edge : edges) {
+    first_visits.push_back(seen.insert(edge.get()).second);
   }
 }
 
-// PATH PROCESSING FUNCTION
-
 void Path::process_path() {
   // Clear the string to start
   test_string.clear();
+  evil_edges.clear();
 
+  PathContext context(edges.size());
   for (unsigned int i = 0; i < edges.size(); i++) {
-    // An edge must be processed first before being added, the function returns
-    // whether the edge is evil and more tests should be added later.
-    bool evil_edge = edges[i]->process_edge(test_string, this);
-    if (evil_edge) {
-      evil_edges.push_back(i);
+    std::string substring = get_substring(i, test_string, context);
+
+    // The first path through an edge creates its evil strings, more tests are
+    // added later from the prefix and substring.
+    if (i < first_visits.size() && first_visits[i] && edges[i]->is_evil()) {
+      EvilEdge evil_edge;
+      evil_edge.index = i;
+      if (edges[i]->get_type() == END_LOOP_EDGE) {
+        evil_edge.prefix_size =
+            context.loop_starts[edges[i]->get_regex_loop().get()];
+        evil_edge.substring = test_string.substr(evil_edge.prefix_size);
+      } else {
+        evil_edge.prefix_size = test_string.size();
+        evil_edge.substring = substring;
+      }
+      evil_edges.push_back(evil_edge);
     }
 
     // Add the substring to the initial string.
-    test_string.append(edges[i]->get_substring());
+    add_substring(i, substring, test_string, context);
+  }
+  substrings = std::move(context.substrings);
+  processed = true;
+}
+
+void Path::ensure_processed() {
+  if (!processed)
+    process_path();
+}
+
+void Path::reset() {
+  test_string.clear();
+  substrings.clear();
+  evil_edges.clear();
+  processed = false;
+}
+
+std::string Path::get_substring(unsigned int i, const std::string &str,
+                                PathContext &context) {
+  const std::shared_ptr<Edge> &edge = edges[i];
+  switch (edge->get_type()) {
+  case BEGIN_LOOP_EDGE:
+    context.loop_starts[edge->get_regex_loop().get()] = str.size();
+    return "";
+  case END_LOOP_EDGE: {
+    std::shared_ptr<RegexLoop> regex_loop = edge->get_regex_loop();
+    unsigned int start = context.loop_starts[regex_loop.get()];
+    return regex_loop->get_extra_iterations(str.substr(start));
   }
+  case BACKREFERENCE_EDGE:
+    return gen_backref_string(edge->get_backref()->get_group_loc(), i, context);
+  default:
+    return edge->get_substring();
+  }
+}
+
+void Path::add_substring(unsigned int i, const std::string &substring,
+                         std::string &str, PathContext &context) {
+  context.substrings[i] = substring;
+  str += substring;
 }
 
 // CHECKER FUNCTIONS
@@ -84,8 +138,8 @@ bool Path::has_leading_caret() {
 }
 
 bool Path::has_trailing_dollar() {
-  for (unsigned int i = edges.size() - 1; i > 0; i--) {
-    switch (edges[i]->get_type()) {
+  for (auto it = edges.rbegin(); it != edges.rend(); it++) {
+    switch ((*it)->get_type()) {
     case DOLLAR_EDGE:
       return true;
     case BEGIN_LOOP_EDGE:
@@ -110,8 +164,8 @@ bool Path::check_anchor_in_middle() {
     switch (edge->get_type()) {
     case CARET_EDGE:
       if (seen_non_caret) {
-        std::string msg =
-            "Generated string has ^ anchor in the middle: " + test_string;
+        std::string msg = "Generated string has ^ anchor in the middle: " +
+                          get_test_string();
         Alert a("anchor middle", msg, seen_non_caret_loc, edge->get_loc());
         Util::get()->add_alert(a);
         return true;
@@ -130,8 +184,8 @@ bool Path::check_anchor_in_middle() {
       seen_non_caret = true;
       seen_non_caret_loc = edge->get_loc();
       if (seen_dollar) {
-        std::string msg =
-            "Generated string has $ anchor in the middle: " + test_string;
+        std::string msg = "Generated string has $ anchor in the middle: " +
+                          get_test_string();
         Alert a("anchor middle", msg, seen_dollar_loc, seen_non_caret_loc);
         Util::get()->add_alert(a);
         return true;
@@ -166,17 +220,21 @@ void Path::check_charsets() {
         if (charset_str.length() > 1 && !ignored) {
           bool found_dup = false;
           for (unsigned int i = 0; i < charsets.size() && !found_dup; i++) {
-            if (charset_str == charsets[i]) {
-              std::string msg = "Duplicate character set of punctuation marks "
-                                "can lead to mismatched punctuation usage";
-              char c1 = charset_ptr->get_valid_character();
-              char c2 = charset_ptr->get_valid_character(c1);
-              Alert a("duplicate punc charset", msg, locs[i], loc);
-              a.has_example = true;
-              a.example = gen_example_string(locs[i], c1, loc, c2);
-              Util::get()->add_alert(a);
-              found_dup = true;
-            }
+            if (charset_str != charsets[i])
+              continue;
+            found_dup = true;
+
+            // skip building the example if already reported
+            if (!Util::get()->is_new_alert("duplicate punc charset", locs[i]))
+              continue;
+            std::string msg = "Duplicate character set of punctuation marks "
+                              "can lead to mismatched punctuation usage";
+            char c1 = charset_ptr->get_valid_character();
+            char c2 = charset_ptr->get_valid_character(c1);
+            Alert a("duplicate punc charset", msg, locs[i], loc);
+            a.has_example = true;
+            a.example = gen_example_string(locs[i], c1, loc, c2);
+            Util::get()->add_alert(a);
           }
           if (!found_dup) {
             // not a duplicate - add to list
@@ -262,76 +320,42 @@ void Path::check_optional_braces() {
   }
 
   // Signal violations
-  if (opt_lparen && opt_rparen) {
-    std::string msg = "Optional ( and ) found - accepts strings that have one "
-                      "but not the other";
-    Alert a("optional brace", msg, opt_lparen_loc, opt_rparen_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lparen_loc, '(', opt_rparen_loc);
-    Util::get()->add_alert(a);
-  }
-  if (opt_lparen && !opt_rparen) {
-    std::string msg =
-        "Optional ( found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_lparen_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lparen_loc, '(');
-    Util::get()->add_alert(a);
-  }
-  if (!opt_lparen && opt_rparen) {
-    std::string msg =
-        "Optional ) found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_rparen_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_rparen_loc, ')');
-    Util::get()->add_alert(a);
-  }
-  if (opt_lcurly && opt_rcurly) {
-    std::string msg = "Optional { and } found - accepts strings that have one "
-                      "but not the other";
-    Alert a("optional brace", msg, opt_lcurly_loc, opt_rcurly_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lcurly_loc, '{', opt_rcurly_loc);
-    Util::get()->add_alert(a);
-  }
-  if (opt_lcurly && !opt_rcurly) {
-    std::string msg =
-        "Optional { found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_lcurly_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lcurly_loc, '{');
-    Util::get()->add_alert(a);
-  }
-  if (!opt_lcurly && opt_rcurly) {
-    std::string msg =
-        "Optional } found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_rcurly_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_rcurly_loc, '}');
-    Util::get()->add_alert(a);
-  }
-  if (opt_lbrace && opt_rbrace) {
-    std::string msg = "Optional [ and ] found - accepts strings that have one "
-                      "but not the other";
-    Alert a("optional brace", msg, opt_lbrace_loc, opt_rbrace_loc);
-    a.has_example = true;
-    a.example = gen_example_string(opt_lbrace_loc, '[', opt_rbrace_loc);
-    Util::get()->add_alert(a);
-  }
-  if (opt_lbrace && !opt_rbrace) {
-    std::string msg =
-        "Optional [ found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_lbrace_loc);
+  add_optional_brace_alert('(', ')', opt_lparen, opt_rparen, opt_lparen_loc,
+                           opt_rparen_loc);
+  add_optional_brace_alert('{', '}', opt_lcurly, opt_rcurly, opt_lcurly_loc,
+                           opt_rcurly_loc);
+  add_optional_brace_alert('[', ']', opt_lbrace, opt_rbrace, opt_lbrace_loc,
+                           opt_rbrace_loc);
+}
+
+void Path::add_optional_brace_alert(char open, char close, bool opt_open,
+                                    bool opt_close, Location open_loc,
+                                    Location close_loc) {
+  if (!opt_open && !opt_close)
+    return;
+
+  // the example is the expensive part, skip it if the alert is a duplicate
+  Location loc = opt_open ? open_loc : close_loc;
+  if (!Util::get()->is_new_alert("optional brace", loc))
+    return;
+
+  if (opt_open && opt_close) {
+    std::string msg = "Optional " + std::string(1, open) + " and " +
+                      std::string(1, close) +
+                      " found - accepts strings that have one but not the "
+                      "other";
+    Alert a("optional brace", msg, open_loc, close_loc);
     a.has_example = true;
-    a.example = gen_example_string(opt_lbrace_loc, '[');
+    a.example = gen_example_string(open_loc, open, close_loc);
     Util::get()->add_alert(a);
-  }
-  if (!opt_lbrace && opt_rbrace) {
-    std::string msg =
-        "Optional ] found - accepts strings that have one but not the other";
-    Alert a("optional brace", msg, opt_rbrace_loc);
+  } else {
+    char c = opt_open ? open : close;
+    std::string msg = "Optional " + std::string(1, c) +
+                      " found - accepts strings that have one but not the "
+                      "other";
+    Alert a("optional brace", msg, loc);
     a.has_example = true;
-    a.example = gen_example_string(opt_rbrace_loc, ']');
+    a.example = gen_example_string(loc, c);
     Util::get()->add_alert(a);
   }
 }
@@ -357,8 +381,9 @@ void Path::check_wild_punctuation() {
       if (prev_edge != -1 && edges[prev_edge]->get_type() == CHARACTER_EDGE) {
         char c = edges[prev_edge]->get_character();
         Location prev_loc = edges[prev_edge]->get_loc();
-        if (ispunct(c) && edges[i]->is_valid_character(c)) {
-          Location loc = edges[i]->get_loc();
+        Location loc = edges[i]->get_loc();
+        if (is_punct_char(c) && edges[i]->is_valid_character(c) &&
+            Util::get()->is_new_alert("wild punctuation", loc)) {
           std::string fix = edges[i]->fix_wild_punctuation(c);
           std::string msg =
               "Wildcard may wish to exclude adjacent punctuation mark " +
@@ -386,8 +411,9 @@ void Path::check_wild_punctuation() {
           edges[next_edge]->get_type() == CHARACTER_EDGE) {
         char c = edges[next_edge]->get_character();
         Location next_loc = edges[next_edge]->get_loc();
-        if (ispunct(c) && edges[i]->is_valid_character(c)) {
-          Location loc = edges[i]->get_loc();
+        Location loc = edges[i]->get_loc();
+        if (is_punct_char(c) && edges[i]->is_valid_character(c) &&
+            Util::get()->is_new_alert("wild punctuation", loc)) {
           std::string fix = edges[i]->fix_wild_punctuation(c);
           std::string msg =
               "Wildcard may wish to exclude adjacent punctuation mark " +
@@ -427,7 +453,8 @@ void Path::check_repeat_punctuation() {
         repeat_str += c;
       }
 
-      if (lower_limit != upper_limit) {
+      if (lower_limit != upper_limit &&
+          Util::get()->is_new_alert("repeat punctuation", curr_loc)) {
         std::string msg =
             "Punctuation mark may be repeated two or more times: " +
             std::string(1, c);
@@ -466,7 +493,8 @@ void Path::check_repeat_punctuation() {
         repeat_str += prev_char;
       }
 
-      if (lower_limit != upper_limit) {
+      if (lower_limit != upper_limit &&
+          Util::get()->is_new_alert("repeat punctuation", prev_loc)) {
         std::string msg =
             "Punctuation mark may be repeated two or more times: " +
             std::string(1, prev_char);
@@ -499,6 +527,8 @@ void Path::check_digit_too_optional() {
     } else if (prev_candidate && edge->is_zero_repeat_end()) {
       prev_repeat = false;
       prev_candidate = false;
+      if (!Util::get()->is_new_alert("digit too optional", prev_loc))
+        continue;
       std::string example = gen_min_iter_string();
 
       bool found_digit = false;
@@ -527,15 +557,15 @@ void Path::check_digit_too_optional() {
 
 std::string Path::gen_example_string(Location loc, char c) {
   std::string example;
-  for (auto &edge : edges) {
-    edge->process_edge(example, this);
+  PathContext context(edges.size());
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    std::string substring = get_substring(i, example, context);
 
-    Location edge_loc = edge->get_loc();
+    Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first == loc.first) {
-      example += c;
-    } else {
-      example += edge->get_substring();
+      substring = std::string(1, c);
     }
+    add_substring(i, substring, example, context);
   }
 
   return example;
@@ -543,26 +573,19 @@ std::string Path::gen_example_string(Location loc, char c) {
 
 std::string Path::gen_example_string(Location loc, char c, char except) {
   std::string example;
-  for (auto &edge : edges) {
-    edge->process_edge(example, this);
+  PathContext context(edges.size());
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    std::string substring = get_substring(i, example, context);
 
-    Location edge_loc = edge->get_loc();
+    Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first == loc.first) {
-      example += c;
-    } else {
-      std::string sub = edge->get_substring();
-      std::string except_str = std::string(1, except);
-      if (sub == except_str) {
-        if (edge->get_type() == CHAR_SET_EDGE) {
-          char loc_c = edge->get_charset()->get_valid_character(except);
-          example += loc_c;
-        } else {
-          example += edge->get_substring();
-        }
-      } else {
-        example += edge->get_substring();
-      }
+      substring = std::string(1, c);
+    } else if (substring == std::string(1, except) &&
+               edges[i]->get_type() == CHAR_SET_EDGE) {
+      char loc_c = edges[i]->get_charset()->get_valid_character(except);
+      substring = std::string(1, loc_c);
     }
+    add_substring(i, substring, example, context);
   }
 
   return example;
@@ -570,17 +593,17 @@ std::string Path::gen_example_string(Location loc, char c, char except) {
 
 std::string Path::gen_example_string(Location loc, char c, Location omit) {
   std::string example;
-  for (auto &edge : edges) {
-    edge->process_edge(example, this);
+  PathContext context(edges.size());
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    std::string substring = get_substring(i, example, context);
 
-    Location edge_loc = edge->get_loc();
+    Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first == loc.first) {
-      example += c;
+      substring = std::string(1, c);
     } else if (edge_loc.first == omit.first) {
       continue;
-    } else {
-      example += edge->get_substring();
     }
+    add_substring(i, substring, example, context);
   }
 
   return example;
@@ -589,17 +612,17 @@ std::string Path::gen_example_string(Location loc, char c, Location omit) {
 std::string Path::gen_example_string(Location loc1, char c1, Location loc2,
                                      char c2) {
   std::string example;
-  for (auto &edge : edges) {
-    edge->process_edge(example, this);
+  PathContext context(edges.size());
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    std::string substring = get_substring(i, example, context);
 
-    Location edge_loc = edge->get_loc();
+    Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first == loc1.first) {
-      example += c1;
+      substring = std::string(1, c1);
     } else if (edge_loc.first == loc2.first) {
-      example += c2;
-    } else {
-      example += edge->get_substring();
+      substring = std::string(1, c2);
     }
+    add_substring(i, substring, example, context);
   }
 
   return example;
@@ -607,52 +630,92 @@ std::string Path::gen_example_string(Location loc1, char c1, Location loc2,
 
 std::string Path::gen_example_string(Location loc, const std::string &replace) {
   std::string example;
+  PathContext context(edges.size());
   bool in_replace = false;
-  for (auto &edge : edges) {
-    edge->process_edge(example, this);
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    std::string substring = get_substring(i, example, context);
 
-    Location edge_loc = edge->get_loc();
+    Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first == loc.first) {
-      example += replace;
+      add_substring(i, replace, example, context);
       in_replace = (edge_loc.second != loc.second);
     } else if (edge_loc.second == loc.second) {
       in_replace = false;
     } else if (!in_replace) {
-      example += edge->get_substring();
+      add_substring(i, substring, example, context);
     }
   }
 
   return example;
 }
 
-std::string Path::gen_backref_string(Location loc) {
-  // Assumes edges have been processed (called during test generation)
+std::string Path::gen_backref_string(Location loc, unsigned int end,
+                                     const PathContext &context) {
   std::string backref;
-  for (auto &edge : edges) {
-    Location edge_loc = edge->get_loc();
+  for (unsigned int i = 0; i < end; i++) {
+    Location edge_loc = edges[i]->get_loc();
     if (edge_loc.first > loc.first && edge_loc.first < loc.second) {
-      backref += edge->get_substring();
+      backref += context.substrings[i];
     }
   }
   return backref;
 }
 
 std::string Path::gen_min_iter_string() {
+  ensure_processed();
   std::string min_iter_string;
-  for (auto &edge : edges) {
-    edge->gen_min_iter_string(min_iter_string);
+
+  // string before each loop, used to drop loops that can be skipped
+  std::unordered_map<const RegexLoop *, std::string> loop_prefixes;
+  for (unsigned int i = 0; i < edges.size(); i++) {
+    const std::shared_ptr<Edge> &edge = edges[i];
+    switch (edge->get_type()) {
+    case STRING_EDGE:
+      if (edge->get_repeat_lower_limit() != 0)
+        min_iter_string += substrings[i];
+      break;
+    case BEGIN_LOOP_EDGE:
+      loop_prefixes[edge->get_regex_loop().get()] = min_iter_string;
+      break;
+    case END_LOOP_EDGE:
+      if (edge->get_repeat_lower_limit() != 0)
+        min_iter_string += substrings[i];
+      else
+        min_iter_string = loop_prefixes[edge->get_regex_loop().get()];
+      break;
+    default:
+      min_iter_string += substrings[i];
+      break;
+    }
   }
   return min_iter_string;
 }
 
 std::vector<std::string>
-Path::gen_evil_strings(const std::set<char> &punct_marks) {
+Path::gen_evil_strings(const std::set<char> &punct_marks,
+                       std::vector<bool> &generated) {
   std::vector<std::string> evil_strings;
 
+  // only process the path if it has edges left to generate strings for
+  generated.resize(edges.size(), false);
+  bool has_new_edges = false;
+  for (unsigned int i = 0; i < first_visits.size(); i++) {
+    if (first_visits[i] && edges[i]->is_evil() && !generated[i])
+      has_new_edges = true;
+  }
+  if (!has_new_edges)
+    return evil_strings;
+  ensure_processed();
+
   // add strings for interesting edges (char sets, strings, and loops)
-  for (int index : evil_edges) {
+  for (const EvilEdge &evil_edge : evil_edges) {
+    if (generated[evil_edge.index])
+      continue;
+    generated[evil_edge.index] = true;
+    std::string prefix = test_string.substr(0, evil_edge.prefix_size);
     std::vector<std::string> new_strings =
-        edges[index]->gen_evil_strings(test_string, punct_marks);
+        edges[evil_edge.index]->gen_evil_strings(
+            test_string, prefix, evil_edge.substring, punct_marks);
     std::vector<std::string>::iterator tsi;
     for (tsi = new_strings.begin(); tsi != new_strings.end(); tsi++) {
       evil_strings.push_back(*tsi);
@@ -25,6 +25,8 @@
 #include "Edge.h"
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class Path {
@@ -32,7 +34,12 @@ class Path {
 public:
   Path() = default;
   explicit Path(unsigned int initial) { states.push_back(initial); }
-  std::string get_test_string() { return test_string; }
+  const std::vector<unsigned int> &get_states() const { return states; }
+  const std::vector<std::shared_ptr<Edge>> &get_edges() const { return edges; }
+  std::string get_test_string() {
+    ensure_processed();
+    return test_string;
+  }
 
   // PATH CONSTRUCTION FUNCTIONS
 
@@ -42,12 +49,20 @@ public:
   // removes the last edge and state
   void remove_last();
 
-  // marks the states in the path as visited
-  void mark_path_visited(bool *visited);
+  // marks the edges this path is the first to visit given the edges of the
+  // earlier paths, the first path through an edge creates its evil strings
+  void set_first_visits(std::unordered_set<const Edge *> &seen);
 
-  // processes path: sets test string and evil edges
+  // processes path: sets test string and evil edges, only reads the edges
+  // so paths can be processed in any order
   void process_path();
 
+  // processes this path if it has not been processed
+  void ensure_processed();
+
+  // clears the test string so the path is processed again
+  void reset();
+
   // CHECKER FUNCTIONS
 
   // returns true if path has a leading caret
@@ -85,14 +100,14 @@ public:
                                  char c2);
   std::string gen_example_string(Location loc, const std::string &replace);
 
-  // generates string based on location
-  std::string gen_backref_string(Location loc);
-
   // generates a string with minimum iterations for repeating constructs
   std::string gen_min_iter_string();
 
-  // generates evil strings for the path
-  std::vector<std::string> gen_evil_strings(const std::set<char> &punct_marks);
+  // generates evil strings for the path, skipping the edges marked in
+  // generated (an equivalent path already generated their strings) and
+  // marking the edges it generates strings for
+  std::vector<std::string> gen_evil_strings(const std::set<char> &punct_marks,
+                                            std::vector<bool> &generated);
 
   // PRINT FUNCTION
 
@@ -100,11 +115,48 @@ public:
   void print();
 
 private:
+  // An edge this path creates evil strings for and the parts of the test
+  // string they are built from
+  struct EvilEdge {
+    unsigned int index;       // index of the edge
+    unsigned int prefix_size; // length of the test string before the construct
+    std::string substring;    // text of the construct in the test string
+  };
+
+  // Strings recorded while building a string along the path
+  struct PathContext {
+    explicit PathContext(unsigned int num_edges) : substrings(num_edges) {}
+
+    // start of the current iteration of each loop
+    std::unordered_map<const RegexLoop *, unsigned int> loop_starts;
+    std::vector<std::string> substrings; // text added for each edge
+  };
+
   std::vector<unsigned int> states; // list of states
   std::vector<std::shared_ptr<Edge>> edges;        // list of edges
+  std::vector<bool> first_visits;   // edges no earlier path visits
   std::string test_string;          // test string associated with path
-  std::vector<unsigned int>
-      evil_edges; // list of evil edges that need processing
+  std::vector<std::string> substrings; // text of each edge in test string
+  std::vector<EvilEdge> evil_edges; // edges that evil strings are created for
+  bool processed{}; // set once test string and evil edges are set
+
+  // returns the text for edge i after str, loop ends repeat the current
+  // iteration and backreferences repeat the text of their group
+  std::string get_substring(unsigned int i, const std::string &str,
+                            PathContext &context);
+
+  // adds the text for edge i to str
+  void add_substring(unsigned int i, const std::string &substring,
+                     std::string &str, PathContext &context);
+
+  // generates the text of the group at loc from the edges before edge end
+  std::string gen_backref_string(Location loc, unsigned int end,
+                                 const PathContext &context);
+
+  // emits violation for one kind of brace if either side is optional
+  void add_optional_brace_alert(char open, char close, bool opt_open,
+                                bool opt_close, Location open_loc,
+                                Location close_loc);
 };
 
 #endif // PATH_H
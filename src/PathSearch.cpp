@@ -0,0 +1,253 @@
+/*  PathSearch.cpp: parallel basis path search
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PathSearch.h"
+#include "Edge.h"
+#include "NFA.h"
+#include "Path.h"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+PathSearch::PathSearch(const NFA &_nfa)
+  : nfa(_nfa)
+  , pending_tasks(0)
+  , queued_tasks(0) {
+}
+
+std::vector<Path> PathSearch::find_paths(unsigned int num_threads) {
+  find_first_entries();
+
+  if (num_threads == 0)
+    num_threads = 1;
+  queues.clear();
+  for (unsigned int i = 0; i < num_threads; i++)
+    queues.emplace_back(new TaskQueue);
+
+  // the calling thread runs the first task and helps with the rest
+  unsigned int initial = nfa.get_initial();
+  PathTask root(initial, Path(initial));
+  pending_tasks = 1;
+  queued_tasks = 1;
+  queues[0]->tasks.push_back(&root);
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < num_threads; i++)
+    threads.emplace_back(&PathSearch::run_worker, this, i);
+  run_worker(0);
+  for (std::thread &thread : threads)
+    thread.join();
+
+  std::vector<Path> paths;
+  paths.reserve(path_counts[initial]);
+  collect_paths(root, paths);
+  return paths;
+}
+
+// The state is first entered by the edge reaching it first in depth first
+// order, each later entry adds one path.
+void PathSearch::find_first_entries() {
+  unsigned int size = nfa.get_size();
+  unsigned int initial = nfa.get_initial();
+  unsigned int final = nfa.get_final();
+  std::vector<bool> visited(size, false);
+  first_entries.assign(size, std::make_pair(size, 0));
+  path_counts.assign(size, 0);
+
+  // states being expanded paired with the index of their next edge
+  std::vector<std::pair<unsigned int, unsigned int>> stack;
+  visited[initial] = true;
+  stack.push_back(std::make_pair(initial, 0));
+  while (!stack.empty()) {
+    unsigned int state = stack.back().first;
+    unsigned int index = stack.back().second;
+    const EdgeList &edges = nfa.get_edges(state);
+    if (state == final)
+      path_counts[state] = 1;
+
+    // done with the state --> add its paths to the state before it
+    if (state == final || index == edges.size()) {
+      stack.pop_back();
+      if (!stack.empty())
+        path_counts[stack.back().first] += path_counts[state];
+      continue;
+    }
+
+    stack.back().second++;
+    unsigned int next_state = edges[index].first;
+    if (visited[next_state]) {
+      path_counts[state]++;
+      continue;
+    }
+    visited[next_state] = true;
+    first_entries[next_state] = std::make_pair(state, index);
+    stack.push_back(std::make_pair(next_state, 0));
+  }
+}
+
+void PathSearch::run_worker(unsigned int thread) {
+  while (pending_tasks > 0) {
+    PathTask *task = take_task(thread);
+    if (!task) {
+      std::unique_lock<std::mutex> lock(idle_mutex);
+      work_ready.wait(lock, [this] {
+        return pending_tasks == 0 || queued_tasks > 0;
+      });
+      continue;
+    }
+    run_task(*task, thread);
+    if (--pending_tasks == 0)
+      notify_workers(true);
+  }
+}
+
+void PathSearch::notify_workers(bool all) {
+  // taking the lock orders the notification after a waiting thread has
+  // checked for work, so the notification cannot be missed
+  std::lock_guard<std::mutex> lock(idle_mutex);
+  if (all)
+    work_ready.notify_all();
+  else
+    work_ready.notify_one();
+}
+
+PathSearch::PathTask *PathSearch::take_task(unsigned int thread) {
+  {
+    TaskQueue &queue = *queues[thread];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      PathTask *task = queue.tasks.back();
+      queue.tasks.pop_back();
+      queued_tasks--;
+      return task;
+    }
+  }
+
+  // steal the oldest task of another thread, it has the most work below it
+  for (unsigned int i = 1; i < queues.size(); i++) {
+    TaskQueue &queue = *queues[(thread + i) % queues.size()];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      PathTask *task = queue.tasks.front();
+      queue.tasks.pop_front();
+      queued_tasks--;
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+void PathSearch::run_task(PathTask &task, unsigned int thread) {
+  unsigned int final = nfa.get_final();
+  Path path = std::move(task.prefix);
+  if (task.state == final) {
+    task.paths.push_back(path);
+    return;
+  }
+
+  // states on the path paired with the index of their next edge
+  std::vector<std::pair<unsigned int, unsigned int>> stack;
+  stack.push_back(std::make_pair(task.state, 0));
+  while (!stack.empty()) {
+    unsigned int state = stack.back().first;
+    unsigned int index = stack.back().second;
+    const EdgeList &edges = nfa.get_edges(state);
+    if (index == edges.size()) {
+      stack.pop_back();
+      if (!stack.empty())
+        path.remove_last();
+      continue;
+    }
+
+    stack.back().second++;
+    unsigned int next_state = edges[index].first;
+    path.append(edges[index].second, next_state);
+    if (first_entries[next_state] != std::make_pair(state, index)) {
+      // state entered again --> one path along the first edges
+      add_first_path(next_state, path, task.paths);
+      path.remove_last();
+    } else if (next_state == final) {
+      task.paths.push_back(path);
+      path.remove_last();
+    } else if (edges.size() > 1 &&
+               path_counts[next_state] >= PATH_TASK_GRAIN) {
+      // split at the branch, another thread may take the subtask
+      std::unique_ptr<PathTask> subtask(new PathTask(next_state, path));
+      PathTask *queued = subtask.get();
+      task.subtasks.push_back(
+          std::make_pair(task.paths.size(), std::move(subtask)));
+      pending_tasks++;
+      {
+        TaskQueue &queue = *queues[thread];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(queued);
+        queued_tasks++;
+      }
+      if (queues.size() > 1)
+        notify_workers(false);
+      path.remove_last();
+    } else {
+      stack.push_back(std::make_pair(next_state, 0));
+    }
+  }
+}
+
+void PathSearch::add_first_path(unsigned int state, Path &path,
+                                std::vector<Path> &paths) {
+  unsigned int final = nfa.get_final();
+  unsigned int length = 0;
+  while (state != final) {
+    const auto &target = nfa.get_edges(state).front();
+    path.append(target.second, target.first);
+    state = target.first;
+    length++;
+  }
+  paths.push_back(path);
+  for (; length > 0; length--)
+    path.remove_last();
+}
+
+void PathSearch::collect_paths(PathTask &root, std::vector<Path> &paths) {
+  // tasks being joined paired with the index of their next subtask, the
+  // paths before that subtask have been added
+  std::vector<std::pair<PathTask *, unsigned int>> stack;
+  stack.push_back(std::make_pair(&root, 0));
+  while (!stack.empty()) {
+    PathTask &task = *stack.back().first;
+    unsigned int index = stack.back().second;
+    unsigned int begin = (index == 0) ? 0 : task.subtasks[index - 1].first;
+    unsigned int end = (index == task.subtasks.size())
+                           ? task.paths.size()
+                           : task.subtasks[index].first;
+    for (unsigned int i = begin; i < end; i++)
+      paths.push_back(std::move(task.paths[i]));
+
+    if (index == task.subtasks.size()) {
+      stack.pop_back();
+    } else {
+      stack.back().second++;
+      stack.push_back(std::make_pair(task.subtasks[index].second.get(), 0));
+    }
+  }
+}
@@ -0,0 +1,110 @@
+/*  PathSearch.h: parallel basis path search
+
+    Copyright (C) 2016-2018  Eric Larson and Anna Kirk
+    elarson@seattleu.edu
+
+    This file is part of EGRET.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PATH_SEARCH_H
+#define PATH_SEARCH_H
+
+#include "NFA.h"
+#include "Path.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Smallest number of paths below a state for its paths to be built by a
+// separate task
+const unsigned long PATH_TASK_GRAIN = 64;
+
+// Finds the basis paths of an NFA, building them on several threads.
+//
+// The paths are the ones of a depth first search that expands a state the
+// first time it is entered and follows the first edges to the final state
+// when it is entered again. Which edge first enters each state only depends
+// on the NFA, so it is found up front without building any paths. The paths
+// below a branching state are then built by tasks on a work-stealing pool:
+// each thread runs the tasks it creates and takes tasks from other threads
+// when it runs out. The paths of a task are joined with the paths of its
+// subtasks in search order, so the paths do not depend on the threads.
+class PathSearch {
+
+public:
+  explicit PathSearch(const NFA &nfa);
+
+  // builds the basis paths using up to num_threads threads
+  std::vector<Path> find_paths(unsigned int num_threads);
+
+private:
+  // Builds the paths below a state, the paths below some of the states it
+  // reaches are built by subtasks
+  struct PathTask {
+    PathTask(unsigned int s, Path p) : state(s), prefix(std::move(p)) {}
+
+    unsigned int state;      // state the task starts from
+    Path prefix;             // path from the initial state to the state
+    std::vector<Path> paths; // paths built by the task
+    // subtasks paired with the number of paths built before each of them
+    std::vector<std::pair<unsigned int, std::unique_ptr<PathTask>>> subtasks;
+  };
+
+  // Tasks waiting to run on one thread, the thread takes from the back and
+  // other threads steal from the front
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<PathTask *> tasks;
+  };
+
+  const NFA &nfa;
+  // edge (source state and index) that first enters each state
+  std::vector<std::pair<unsigned int, unsigned int>> first_entries;
+  std::vector<unsigned long> path_counts; // paths below each state
+  std::vector<std::unique_ptr<TaskQueue>> queues; // one queue per thread
+  std::atomic<unsigned int> pending_tasks; // tasks not yet finished
+  std::atomic<unsigned int> queued_tasks;  // tasks waiting in the queues
+  std::mutex idle_mutex;                   // guards waiting for work
+  std::condition_variable work_ready;      // a task was queued or all done
+
+  // finds the edge first entering each state and counts the paths
+  void find_first_entries();
+
+  // runs tasks until every task has finished, sleeping while there are
+  // no queued tasks to take
+  void run_worker(unsigned int thread);
+
+  // wakes the idle threads after a task is queued or the last one finishes
+  void notify_workers(bool all);
+
+  // takes a task from the thread's queue or steals one from another thread
+  PathTask *take_task(unsigned int thread);
+
+  // builds the paths of a task, adding subtasks to the thread's queue
+  void run_task(PathTask &task, unsigned int thread);
+
+  // adds the path continuing from the state along the first edges
+  void add_first_path(unsigned int state, Path &path, std::vector<Path> &paths);
+
+  // joins the paths of the tasks in search order
+  void collect_paths(PathTask &root, std::vector<Path> &paths);
+};
+
+#endif // PATH_SEARCH_H
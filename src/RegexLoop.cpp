@@ -20,20 +20,18 @@
 */
 
 #include "RegexLoop.h"
+#include "Util.h"
 #include <iostream>
+#include <sstream>
 #include <string>
 
-void RegexLoop::set_curr_substring(const std::string &test_string) {
-  curr_substring = test_string.substr(curr_prefix.size());
-}
-
-std::string RegexLoop::get_substring() {
+std::string RegexLoop::get_extra_iterations(const std::string &iteration) const {
   // The test string already contains one iteration from the elements in the
   // loop. This function return additional iterations if the lower bound is
   // greater than 1.
   std::string extra;
   for (int j = 1; j < repeat_lower; j++) {
-    extra += curr_substring;
+    extra += iteration;
   }
 
   return extra;
@@ -43,15 +41,10 @@ bool RegexLoop::is_opt_repeat() const {
   return (repeat_lower == 0 && repeat_upper == 1);
 }
 
-void RegexLoop::gen_min_iter_string(std::string &min_iter_string) {
-  if (repeat_lower != 0) {
-    min_iter_string += get_substring();
-  } else {
-    min_iter_string = curr_prefix;
-  }
-}
-
-std::vector<std::string> RegexLoop::gen_evil_strings(const std::string& test_string) {
+std::vector<std::string>
+RegexLoop::gen_evil_strings(const std::string &test_string,
+                            const std::string &prefix,
+                            const std::string &substring, Location loc) {
   std::vector<std::string> evil_strings;
 
   // Create suffix: substring after the loop
@@ -81,28 +74,38 @@ std::vector<std::string> RegexLoop::gen_evil_strings(const std::string& test_str
 
       // Add enough path elements to get to the upper bound (note if lower bound
       // is zero, the path has one iteration so the starting point is bumped to
-      // one). The variable path_elements is initialized to substring since
-      // suffix has one substring less than lower bound.
+      // one). The number of copies includes the substring already in the
+      // path since suffix has one substring less than lower bound.
       int base_iterations = repeat_lower;
       if (base_iterations == 0)
         base_iterations = 1;
-      std::string path_elements = substring;
-      for (int i = base_iterations; i < repeat_upper; i++) {
-        path_elements += substring;
+      unsigned int copies = repeat_upper - base_iterations + 1;
+
+      unsigned int max_repeat = Util::get()->get_max_repeat();
+      bool sampled = max_repeat != 0 && copies > max_repeat;
+      if (!sampled) {
+        // Add the upper bound string and the string with one more iteration
+        // past the upper bound.
+        evil_strings.push_back(
+            gen_iterations(prefix, substring, copies, suffix));
+        evil_strings.push_back(
+            gen_iterations(prefix, substring, copies + 1, suffix));
+      } else {
+        // Bounds too large to write out are sampled instead: one more than
+        // the path, the middle and the limit, all within the bounds.
+        evil_strings.push_back(one_more_string);
+        for (unsigned int sample : {max_repeat / 2, max_repeat}) {
+          if (sample > 2)
+            evil_strings.push_back(
+                gen_iterations(prefix, substring, sample, suffix));
+        }
+        std::stringstream s;
+        s << "Repeat upper bound " << repeat_upper
+          << " is sampled, strings at and past the bound are not generated";
+        Alert a("repeat bound", s.str(), loc);
+        a.warning = true;
+        Util::get()->add_alert(a);
       }
-
-      // Add the upper bound string.
-      std::string upper_bound_string = prefix;
-      upper_bound_string += path_elements;
-      upper_bound_string += suffix;
-      evil_strings.push_back(upper_bound_string);
-
-      // Add the string with one more iteration past the upper bound.
-      std::string past_bound_string = prefix;
-      past_bound_string += path_elements;
-      past_bound_string += substring;
-      past_bound_string += suffix;
-      evil_strings.push_back(past_bound_string);
     }
   }
 
@@ -123,6 +126,18 @@ std::vector<std::string> RegexLoop::gen_evil_strings(const std::string& test_str
   return evil_strings;
 }
 
+std::string RegexLoop::gen_iterations(const std::string &prefix,
+                                      const std::string &substring,
+                                      unsigned int copies,
+                                      const std::string &suffix) {
+  std::string str = prefix;
+  str.reserve(prefix.size() + copies * substring.size() + suffix.size());
+  for (unsigned int i = 0; i < copies; i++)
+    str += substring;
+  str += suffix;
+  return str;
+}
+
 void RegexLoop::print() const {
   if (repeat_lower == 0 && repeat_upper == -1)
     std::cout << "*";
@@ -22,6 +22,7 @@
 #ifndef REGEX_LOOP_H
 #define REGEX_LOOP_H
 
+#include "Util.h"
 #include <string>
 #include <utility>
 #include <vector>
@@ -34,25 +35,23 @@ public:
     repeat_upper = upper;
   }
 
-  // setters
-  void set_prefix(std::string p) { prefix = std::move(p); }
-  void set_substring_from_curr() { substring = curr_substring; }
-  void set_curr_prefix(std::string p) { curr_prefix = std::move(p); }
-  void set_curr_substring(const std::string &test_string);
-
   // getters
   int get_repeat_lower() const { return repeat_lower; }
   int get_repeat_upper() const { return repeat_upper; }
-  std::string get_substring();
+
+  // returns the iterations to add after the one in the test string so the
+  // loop is repeated at least the lower bound number of times
+  std::string get_extra_iterations(const std::string &iteration) const;
 
   // property functions - used by checker
   bool is_opt_repeat() const;
 
-  // generate minimum iteration string
-  void gen_min_iter_string(std::string &min_iter_string);
-
-  // generate evil strings
-  std::vector<std::string> gen_evil_strings(const std::string& test_string);
+  // generate evil strings, prefix is the path string before the loop,
+  // substring is one iteration of the loop and loc is the loop's location
+  std::vector<std::string> gen_evil_strings(const std::string &test_string,
+                                            const std::string &prefix,
+                                            const std::string &substring,
+                                            Location loc);
 
   // print the regex loop
   void print() const;
@@ -61,12 +60,11 @@ private:
   int repeat_lower; // lower bound for repeat quantifiers
   int repeat_upper; // upper bound for repeat quantifiers (-1 if no bound)
 
-  // TODO: Rename these to something like evil prefix
-  std::string prefix;    // prefix of test string before the loop
-  std::string substring; // substring corresponding to loop
-
-  std::string curr_prefix;    // current path string up to visiting this node
-  std::string curr_substring; // current substring corresponding to this string
+  // returns the prefix, copies of the substring and the suffix
+  static std::string gen_iterations(const std::string &prefix,
+                                    const std::string &substring,
+                                    unsigned int copies,
+                                    const std::string &suffix);
 };
 
 #endif // REGEX_LOOP_H
@@ -25,14 +25,10 @@
 #include <set>
 #include <string>
 
-void RegexString::gen_min_iter_string(std::string &min_iter_string) {
-  if (repeat_lower != 0) {
-    min_iter_string.append(get_substring());
-  }
-}
-
 std::vector<std::string>
 RegexString::gen_evil_strings(const std::string &test_string,
+                              const std::string &prefix,
+                              const std::string &substring,
                               const std::set<char> &punct_marks) {
   std::vector<std::string> evil_substrings; // set of evil substrings
 
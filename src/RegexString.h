@@ -39,12 +39,10 @@ public:
     repeat_upper = upper;
   }
 
-  // setters
-  void set_prefix(std::string p) { prefix = std::move(p); }
-  void set_substring(std::string s) { substring = std::move(s); }
+  // clears the state set by checking paths
+  void reset() { char_set->reset(); }
 
   // getters
-  std::string get_substring() { return substring; }
   int get_repeat_lower() const { return repeat_lower; }
   int get_repeat_upper() const { return repeat_upper; }
   std::shared_ptr<CharSet> get_charset() { return char_set; }
@@ -64,11 +62,11 @@ public:
   }
   char get_repeat_punc_char() { return char_set->get_repeat_punc_char(); }
 
-  // generate minimum iterations string
-  void gen_min_iter_string(std::string &min_iter_string);
-
-  // generate evil strings
+  // generate evil strings, prefix is the path string before the regex
+  // string and substring is the text used for it
   std::vector<std::string> gen_evil_strings(const std::string &test_string,
+                                            const std::string &prefix,
+                                            const std::string &substring,
                                             const std::set<char> &punct_marks);
 
   // print the regex string
@@ -78,9 +76,6 @@ private:
   std::shared_ptr<CharSet> char_set; // corresponding character set
   int repeat_lower;  // lower bound for string
   int repeat_upper;  // upper bound for string
-
-  std::string prefix;    // prefix of test string before the loop
-  std::string substring; // substring corresponding to this string
 };
 
 #endif // REGEX_STRING_H
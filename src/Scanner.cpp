@@ -23,6 +23,7 @@
 */
 
 #include "Scanner.h"
+#include "CharClass.h"
 #include "Stats.h"
 #include "Util.h"
 #include <cassert>
@@ -31,11 +32,25 @@
 #include <string>
 #include <vector>
 
-void Scanner::init(std::string in) {
+void Scanner::init(const std::string &in) {
   unsigned int idx = 0;
   bool in_set = false; // set to true when in the middle of set []
+  tokens.reserve(tokens.size() + in.length());
   while (idx < in.length()) {
 
+    // characters without a special meaning are literals both inside and
+    // outside of sets, so a run of them is emitted without the switch
+    if (!is_special_char(in[idx])) {
+      Token token {};
+      token.type = CHARACTER;
+      for (; idx < in.length() && !is_special_char(in[idx]); idx++) {
+        token.loc = std::make_pair(idx, idx);
+        token.character = in[idx];
+        tokens.push_back(token);
+      }
+      continue;
+    }
+
     Token token;
     token.loc.first = idx;
     switch (in[idx]) {
@@ -403,7 +418,7 @@ void Scanner::init(std::string in) {
   }
 }
 
-char Scanner::get_next_char(std::string in, unsigned int &idx) {
+char Scanner::get_next_char(const std::string &in, unsigned int &idx) {
   idx++;
   if (idx >= in.length()) {
     throw EgretException("ERROR (parse error): Input string ended prematurely");
@@ -411,7 +426,7 @@ char Scanner::get_next_char(std::string in, unsigned int &idx) {
   return in[idx];
 }
 
-Token Scanner::process_octal(std::string in, unsigned int &idx,
+Token Scanner::process_octal(const std::string &in, unsigned int &idx,
                              char first_digit) {
   bool octal_found = false;
   bool only_one_digit = false;
@@ -644,7 +659,7 @@ Token Scanner::process_repeat(const std::string& in, unsigned int &idx) {
   // Keep looping while reading in digits.
   std::string count_str;
   char c = get_next_char(in, idx);
-  while (isdigit(c)) {
+  while (is_digit_char(c)) {
     count_str += c;
     c = get_next_char(in, idx);
   }
@@ -691,7 +706,7 @@ Token Scanner::process_repeat(const std::string& in, unsigned int &idx) {
   // Grab second digit after the comma if one exists
   count_str = "";
   c = get_next_char(in, idx);
-  while (isdigit(c)) {
+  while (is_digit_char(c)) {
     count_str += c;
     c = get_next_char(in, idx);
   }
@@ -75,7 +75,7 @@ public:
   std::vector<Token> get_tokens() { return tokens; }
 
   // scans through input string and creates a vector of tokens
-  void init(std::string in);
+  void init(const std::string &in);
 
   // TODO: Consider returning a token instead of all these specialized functions
   // returns type for current token
@@ -122,10 +122,11 @@ private:
   unsigned index;            // iterator
 
   // get next character from input string
-  char get_next_char(std::string in, unsigned int &idx);
+  char get_next_char(const std::string &in, unsigned int &idx);
 
   // process octal character
-  Token process_octal(std::string in, unsigned int &idx, char first_digit);
+  Token process_octal(const std::string &in, unsigned int &idx,
+                      char first_digit);
 
   // process hexadecimal character
   Token process_hex(const std::string& in, unsigned int &idx, int num_digits);
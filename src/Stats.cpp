@@ -26,7 +26,7 @@
 #include <utility>
 #include <vector>
 
-void Stats::add(std::string tag, std::string name, int value) {
+void Stats::add(std::string tag, std::string name, long value) {
   Stat stat = {std::move(tag), std::move(name), value};
   statList.push_back(stat);
 }
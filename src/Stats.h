@@ -28,19 +28,22 @@
 class Stats {
 
 public:
+  struct Stat {
+    std::string tag;
+    std::string name;
+    long value;
+  };
+
   // adds a stat to the list of stats
-  void add(std::string tag, std::string name, int value);
+  void add(std::string tag, std::string name, long value);
+
+  // returns the stats in the order added
+  const std::vector<Stat> &get_stats() const { return statList; }
 
   // print the stats
   void print();
 
 private:
-  struct Stat {
-    std::string tag;
-    std::string name;
-    int value;
-  };
-
   std::vector<Stat> statList;
 };
 
@@ -26,77 +26,137 @@
 #include "NFA.h"
 #include "Path.h"
 #include <algorithm>
+#include <cassert>
 #include <iostream>
+#include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 // TEST STRING GENERATION FUNCTIONS
 
 std::vector<std::string> TestGenerator::gen_test_strings() {
-  // get initial strings
-  get_initial_strings();
-
-  // TODO: Move to egret.cpp after path processing?
-  // debug - print initial strings from basis paths
-  if (debug_mode) {
-    std::cout << "Initial Test Strings: " << std::endl;
-    for (auto &test_string : test_strings) {
-      std::cout << test_string << std::endl;
-    }
-  }
-
-  // gen minimum iteration strings
-  gen_min_iter_strings();
-
-  // gen evil strings
-  gen_evil_strings();
-
-  // TODO: Create a function that checks for duplicates each time a string is
-  // added? create return set with no duplicates
+  // create return set with no duplicates, in generation order
   std::vector<std::string> return_strs;
-  for (auto &test_string : test_strings) {
-    if (!(std::find(return_strs.begin(), return_strs.end(), test_string) !=
-          return_strs.end())) {
-      return_strs.insert(return_strs.begin(), test_string);
-    }
-  }
-
-  // record number of generated strings for stats
-  num_gen_strings = return_strs.size();
+  std::string test_string;
+  while (next_test_string(test_string))
+    return_strs.push_back(test_string);
 
   return return_strs;
 }
 
-void TestGenerator::get_initial_strings() {
-  std::vector<Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    test_strings.push_back(path_iter->get_test_string());
+bool TestGenerator::next_test_string(std::string &test_string) {
+  while (true) {
+    while (next_pending < pending.size()) {
+      std::string &pending_string = pending[next_pending++];
+      if (seen.insert(pending_string).second) {
+        test_string = std::move(pending_string);
+
+        // record number of generated strings for stats
+        num_gen_strings++;
+        return true;
+      }
+    }
+
+    pending.clear();
+    next_pending = 0;
+    if (!gen_path_strings())
+      return false;
   }
 }
 
-void TestGenerator::gen_min_iter_strings() {
-  if (debug_mode) {
-    std::cout << "Minimum Iteration Test Strings: " << std::endl;
+bool TestGenerator::gen_path_strings() {
+  while (phase == START_PHASE || next_path == paths.size()) {
+    if (phase == EVIL_PHASE || phase == DONE_PHASE) {
+      phase = DONE_PHASE;
+      return false;
+    }
+    start_phase(static_cast<GenPhase>(phase + 1));
+  }
+
+  unsigned int i = next_path++;
+  switch (phase) {
+  case INITIAL_PHASE:
+    if (first_equivalents[i] == i) {
+      pending.push_back(paths[i].get_test_string());
+      if (debug_mode)
+        std::cout << pending.back() << std::endl;
+    }
+    break;
+  case MIN_ITER_PHASE:
+    if (first_equivalents[i] == i) {
+      pending.push_back(paths[i].gen_min_iter_string());
+      if (debug_mode)
+        std::cout << pending.back() << std::endl;
+    }
+    break;
+  case EVIL_PHASE:
+    pending = paths[i].gen_evil_strings(punct_marks,
+                                        generated_edges[first_equivalents[i]]);
+    break;
+  default:
+    assert(false);
   }
+  return true;
+}
+
+void TestGenerator::start_phase(GenPhase next_phase) {
+  phase = next_phase;
+  next_path = 0;
+
+  switch (phase) {
+  case INITIAL_PHASE:
+    // strings of equivalent paths are duplicates so they are not generated
+    find_equivalent_paths();
+    generated_edges.assign(paths.size(), std::vector<bool>());
 
-  std::vector<Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    std::string min_iter_string = path_iter->gen_min_iter_string();
-    test_strings.push_back(min_iter_string);
+    // debug - print initial strings from basis paths
     if (debug_mode)
-      std::cout << min_iter_string << std::endl;
+      std::cout << "Initial Test Strings: " << std::endl;
+    break;
+  case MIN_ITER_PHASE:
+    if (debug_mode)
+      std::cout << "Minimum Iteration Test Strings: " << std::endl;
+    break;
+  default:
+    break;
   }
 }
 
-void TestGenerator::gen_evil_strings() {
-  std::vector<Path>::iterator path_iter;
-  for (path_iter = paths.begin(); path_iter != paths.end(); path_iter++) {
-    std::vector<std::string> evil_strings =
-        path_iter->gen_evil_strings(punct_marks);
-    std::vector<std::string>::iterator si;
-    for (si = evil_strings.begin(); si != evil_strings.end(); si++) {
-      test_strings.push_back(*si);
+// Edges with the same key add the same text and evil strings given the same
+// path, so paths whose edges have the same keys have the same test string and
+// minimum iteration string, and the same evil strings for each edge.
+void TestGenerator::find_equivalent_paths() {
+  first_equivalents.clear();
+  num_equivalent_paths = 0;
+
+  // edges with the same key get the same id, edges without a key are only
+  // equivalent to themselves
+  std::unordered_map<std::string, unsigned int> key_ids;
+  std::unordered_map<const Edge *, unsigned int> edge_ids;
+  std::map<std::vector<unsigned int>, unsigned int> path_ids;
+  unsigned int num_ids = 0;
+  for (unsigned int i = 0; i < paths.size(); i++) {
+    std::vector<unsigned int> ids;
+    for (const std::shared_ptr<Edge> &edge : paths[i].get_edges()) {
+      auto it = edge_ids.find(edge.get());
+      if (it == edge_ids.end()) {
+        std::string key = edge->get_gen_key();
+        unsigned int id = num_ids;
+        if (!key.empty())
+          id = key_ids.insert(std::make_pair(key, num_ids)).first->second;
+        if (id == num_ids)
+          num_ids++;
+        it = edge_ids.insert(std::make_pair(edge.get(), id)).first;
+      }
+      ids.push_back(it->second);
     }
+
+    unsigned int first = path_ids.insert(std::make_pair(ids, i)).first->second;
+    first_equivalents.push_back(first);
+    if (first != i)
+      num_equivalent_paths++;
   }
 }
 
@@ -105,5 +165,6 @@ void TestGenerator::gen_evil_strings() {
 void TestGenerator::add_stats(Stats &stats) {
   // TODO: Should paths be included here?
   stats.add("PATHS", "Paths", paths.size());
+  stats.add("PATHS", "Equivalent paths", num_equivalent_paths);
   stats.add("PATHS", "Strings", num_gen_strings);
 }
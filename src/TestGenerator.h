@@ -28,6 +28,7 @@
 #include "Path.h"
 #include <set>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include "Stats.h"
@@ -39,12 +40,22 @@ public:
     paths = std::move(p);
     punct_marks = std::move(m);
     debug_mode = d;
+    phase = START_PHASE;
+    next_path = 0;
+    next_pending = 0;
     num_gen_strings = 0;
+    num_equivalent_paths = 0;
   }
 
-  // generate test strings
+  // generate test strings, latest unique string first
   std::vector<std::string> gen_test_strings();
 
+  // sets the next unique test string in generation order (initial strings,
+  // then minimum iteration strings, then evil strings), returns false once
+  // every string has been returned. Strings are generated a path at a time
+  // as they are needed, so stopping early skips the remaining work.
+  bool next_test_string(std::string &test_string);
+
   // add test generation stats
   void add_stats(Stats &stats);
 
@@ -53,19 +64,41 @@ private:
   std::set<char> punct_marks; // set of punct marks
   bool debug_mode;            // set if debug mode is on
 
-  std::vector<std::string> test_strings; // list of test strings
+  // the kinds of strings generated in order
+  enum GenPhase {
+    START_PHASE,
+    INITIAL_PHASE,
+    MIN_ITER_PHASE,
+    EVIL_PHASE,
+    DONE_PHASE
+  };
+
+  GenPhase phase;                   // kind of strings being generated
+  unsigned int next_path;           // next path to generate strings for
+  std::vector<std::string> pending; // strings generated but not returned
+  unsigned int next_pending;        // next pending string to return
+  std::unordered_set<std::string> seen; // strings returned so far
+
+  // earliest path generating the same strings as each path
+  std::vector<unsigned int> first_equivalents;
+
+  // edges of each path that evil strings were generated for, shared by the
+  // equivalent paths
+  std::vector<std::vector<bool>> generated_edges;
 
   int num_gen_strings; // number of generated strings (for stats)
+  int num_equivalent_paths; // paths equivalent to an earlier path (for stats)
 
   // TEST STRING GENERATION FUNCTIONS
 
-  // get initial set of strings
-  void get_initial_strings();
+  // finds the paths whose edges generate the same strings as an earlier path
+  void find_equivalent_paths();
 
-  // generate minimum iteration strings
-  void gen_min_iter_strings();
+  // generates the pending strings of the next path, moving on to the next
+  // phase after the last path, returns false once every phase is done
+  bool gen_path_strings();
 
-  // generates evil strings
-  void gen_evil_strings();
+  // starts generating the strings of a phase
+  void start_phase(GenPhase next_phase);
 };
 #endif // TEST_GENERATOR_H
@@ -20,6 +20,7 @@
 */
 
 #include "Util.h"
+#include <cctype>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -33,25 +34,47 @@ std::shared_ptr<Util> Util::get() {
   return inst;
 }
 
-void Util::init(std::string r, bool c, bool w, std::string s) {
+void Util::init(std::string r, bool c, std::string s,
+                unsigned int max_alerts, unsigned int max_repeat) {
   regex = std::move(r);
   check_mode = c;
-  web_mode = w;
   base_substring = std::move(s);
+  this->max_alerts = max_alerts;
+  this->max_repeat = max_repeat;
   alerts.clear();
   prev_alerts.clear();
+  num_violations = 0;
+}
+
+void Util::check_base_substring(const std::string &s) {
+  if (s.length() < 2) {
+    throw EgretException("ERROR (bad arguments): Base substring must have at "
+                         "least two letters");
+  }
+
+  for (char i : s) {
+    if (!isalpha(i)) {
+      throw EgretException(
+          "ERROR (bad arguments): Base substring can only contain letters");
+    }
+  }
+}
+
+bool Util::is_new_alert(const std::string &type, Location loc1) const {
+  if (alert_limit_reached())
+    return false;
+  return prev_alerts.find(std::make_pair(type, loc1.first)) == prev_alerts.end();
 }
 
 void Util::add_alert(const Alert& alert) {
+  // Drop violations past the limit
+  if (!alert.warning && alert_limit_reached())
+    return;
+
   // Create type, location pair
   std::pair<std::string, int> alert_pair =
       make_pair(alert.type, alert.loc1.first);
 
-  // Line break
-  std::string lb = web_mode ? "<br>" : "\n";
-  std::string start = web_mode ? "<mark>" : "\033[33;44;1m";
-  std::string end = web_mode ? "</mark>" : "\033[0m";
-
   if (prev_alerts.find(alert_pair) == prev_alerts.end()) {
     // New error - add to list of previous alerts
     prev_alerts.insert(alert_pair);
@@ -61,39 +84,54 @@ void Util::add_alert(const Alert& alert) {
   }
 
   // Ignore warnings in check mode (warnings only relevant in test generation
-  // mode)
-  if (alert.warning && check_mode)
+  // mode), except for warnings that the check did not finish
+  if (alert.warning && !alert.incomplete && check_mode)
     return;
 
+  if (!alert.warning)
+    num_violations++;
+  alerts.push_back(alert);
+}
+
+std::string Alert::render(const std::string &regex, bool web_mode) const {
+  // Line break
+  std::string lb = web_mode ? "<br>" : "\n";
+  std::string start = web_mode ? "<mark>" : "\033[33;44;1m";
+  std::string end = web_mode ? "</mark>" : "\033[0m";
+
   // Produce alert message
   std::stringstream s;
-  if (alert.warning)
+  if (warning)
     s << "WARNING (";
   else
     s << "VIOLATION (";
-  s << alert.type << "): " << alert.message << lb;
+  s << type << "): " << message;
+  for (auto &detail : details) {
+    s << lb << "..." << detail.first << ": " << detail.second;
+  }
+  s << lb;
 
-  if (alert.loc1.first != -1) {
+  if (loc1.first != -1) {
     s << "...Regex: ";
 
     for (int i = 0; i < (int)regex.size(); i++) {
-      if (i == alert.loc1.first || i == alert.loc2.first) {
+      if (i == loc1.first || i == loc2.first) {
         s << start;
       }
       s << regex[i];
-      if (i == alert.loc1.second || i == alert.loc2.second) {
+      if (i == loc1.second || i == loc2.second) {
         s << end;
       }
     }
     s << lb;
   }
 
-  if (alert.has_suggest) {
-    s << "...Suggested fix: " << alert.suggest << lb;
+  if (has_suggest) {
+    s << "...Suggested fix: " << suggest << lb;
   }
 
-  if (alert.has_example) {
-    s << "...Example accepted string: " << alert.example << lb;
+  if (has_example) {
+    s << "...Example accepted string: " << example << lb;
   }
-  alerts.push_back(s.str());
+  return s.str();
 }
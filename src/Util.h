@@ -31,15 +31,21 @@
 // Location
 typedef std::pair<int, int> Location;
 
+// Default for the largest number of loop iterations written out in an evil
+// string, larger bounds are sampled up to this count
+const unsigned int DEFAULT_MAX_REPEAT = 1000;
+
 struct Alert {
 
   bool warning;
+  bool incomplete = false; // warning that the check did not finish
   std::string type;
   std::string message;
   bool has_suggest;
   std::string suggest;
   bool has_example;
   std::string example;
+  std::vector<std::pair<std::string, std::string>> details;
   Location loc1;
   Location loc2;
 
@@ -100,6 +106,24 @@ struct Alert {
     loc1 = l1;
     loc2 = l2;
   }
+
+  // adds a labeled string shown after the message
+  void add_detail(std::string label, std::string value) {
+    details.push_back(std::make_pair(std::move(label), std::move(value)));
+  }
+
+  // renders the alert as text, highlighting its locations in the regex
+  std::string render(const std::string &regex, bool web_mode) const;
+};
+
+// Matching time of one repetition's attack string at increasing pump counts
+struct RepeatTiming {
+  Location loc;        // location of the repeated subexpression
+  std::string subexpr; // repeated subexpression, including its quantifier
+  std::string pump;    // string repeated in the attack string
+  bool exponential;    // set if the repetition is exponentially ambiguous
+  std::vector<std::pair<unsigned int, double>> samples; // <pumps, seconds>
+  std::string growth;                                   // fitted growth curve
 };
 
 class Util {
@@ -107,17 +131,35 @@ class Util {
 public:
   static std::shared_ptr<Util> get();
 
-  void init(std::string r, bool c, bool w, std::string s);
+  // sets global options, a nonzero max_alerts stops adding violations once
+  // that many have been added, a nonzero max_repeat limits the number of loop
+  // iterations written out for large repeat bounds
+  void init(std::string r, bool c, std::string s, unsigned int max_alerts = 0,
+            unsigned int max_repeat = DEFAULT_MAX_REPEAT);
+
+  // throws an exception unless the base substring is two or more letters
+  static void check_base_substring(const std::string &s);
 
   bool is_check_mode() const { return check_mode; }
-  bool is_web_mode() const { return web_mode; }
+  void set_check_mode(bool c) { check_mode = c; }
   std::string get_base_substring() { return base_substring; }
+  unsigned int get_max_repeat() const { return max_repeat; }
   std::string get_regex() { return regex; }
-  std::vector<std::string> get_alerts() { return alerts; }
+  const std::vector<Alert> &get_alerts() const { return alerts; }
 
   // Alerts
   void add_alert(const Alert& alert);
 
+  // returns true if an alert of this type and location would be added (not a
+  // duplicate or past the limit), lets callers skip building examples for
+  // alerts that would be dropped
+  bool is_new_alert(const std::string &type, Location loc1) const;
+
+  // returns true once the maximum number of violations has been added
+  bool alert_limit_reached() const {
+    return max_alerts != 0 && num_violations >= max_alerts;
+  }
+
   // TODO: Possibly create a new regex class where the "fixing" functions
   // reside?
 private:
@@ -126,14 +168,16 @@ private:
 
   // Global options
   bool check_mode{};
-  bool web_mode{};
   std::string base_substring;
+  unsigned int max_alerts{}; // maximum number of violations (0 if no limit)
+  unsigned int max_repeat{}; // maximum iterations written out (0 if no limit)
 
   std::string regex; // original regular expression
 
   // Alerts
-  std::vector<std::string> alerts;                   // vector of alert strings
+  std::vector<Alert> alerts;                         // alerts in emitted order
   std::set<std::pair<std::string, int>> prev_alerts; // all previous alerts
+  unsigned int num_violations{};                     // non-warning alerts
 };
 
 // TODO: Can this exception be folded into util class above?
@@ -19,7 +19,10 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "egret.h"
+#include "BacktrackTimer.h"
 #include "Checker.h"
+#include "DFA.h"
 #include "NFA.h"
 #include "ParseTree.h"
 #include "Path.h"
@@ -28,104 +31,243 @@
 #include "TestGenerator.h"
 #include "Util.h"
 #include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
-std::vector<std::string>
-run_engine(const std::string& regex, const std::string& base_substring,
-           bool check_mode = false, bool web_mode = false,
-           bool debug_mode = false, bool stat_mode = false) {
-  Stats stats;
-  std::vector<std::string> test_strings;
+// runs the engine pipeline once, running the checker and/or the test
+// generator on the same basis paths
+static EgretResult run_pipeline(const std::string &regex,
+                                const std::string &base_substring,
+                                bool check_mode, bool gen_mode,
+                                bool debug_mode, bool stat_mode,
+                                bool timing_mode, unsigned int max_alerts,
+                                unsigned int max_repeat) {
+  EgretResult result;
+  Stats &stats = result.stats;
+  std::vector<std::string> &test_strings = result.test_strings;
+  result.regex = regex;
 
-  try {
+  // check and convert base substring
+  Util::check_base_substring(base_substring);
 
-    // check and convert base substring
-    if (base_substring.length() < 2) {
-      throw EgretException("ERROR (bad arguments): Base substring must have at "
-                           "least two letters");
-    }
+  // set global options (generation mode rules apply if generating tests)
+  Util::get()->init(regex, !gen_mode, base_substring, max_alerts, max_repeat);
 
-    for (char i : base_substring) {
-      if (!isalpha(i)) {
-        throw EgretException(
-            "ERROR (bad arguments): Base substring can only contain letters");
-      }
-    }
+  // start debug mode
+  if (debug_mode)
+    std::cout << "RegEx: " << regex << std::endl;
 
-    // set global options
-    Util::get()->init(regex, check_mode, web_mode, base_substring);
+  // initialize scanner with regex
+  Scanner scanner;
+  scanner.init(regex);
+  if (debug_mode)
+    scanner.print();
+  if (stat_mode)
+    scanner.add_stats(stats);
 
-    // start debug mode
-    if (debug_mode)
-      std::cout << "RegEx: " << regex << std::endl;
+  // build parse tree
+  ParseTree tree;
+  tree.build(scanner);
+  if (debug_mode)
+    tree.print();
+  if (stat_mode)
+    tree.add_stats(stats);
 
-    // initialize scanner with regex
-    Scanner scanner;
-    scanner.init(regex);
-    if (debug_mode)
-      scanner.print();
-    if (stat_mode)
-      scanner.add_stats(stats);
+  // store stuff out of tree before it gets moved
+  auto punct_marks = tree.get_punct_marks();
+  std::map<int, Location> repeat_spans;
+  if (timing_mode)
+    repeat_spans = tree.get_repeat_spans();
 
-    // build parse tree
-    ParseTree tree;
-    tree.build(scanner);
-    if (debug_mode)
-      tree.print();
-    if (stat_mode)
-      tree.add_stats(stats);
+  // build NFA
+  NFA nfa;
+  nfa.build(tree);
+  nfa.optimize();
+  if (debug_mode)
+    nfa.print();
+  if (stat_mode)
+    nfa.add_stats(stats);
 
-    // store stuff out of tree before it gets moved
-    auto punct_marks = tree.get_punct_marks();
+  // traverse NFA basis paths, a path is processed when its strings are needed
+  std::vector<Path> paths =
+      nfa.find_basis_paths(std::thread::hardware_concurrency());
 
-    // build NFA
-    NFA nfa;
-    nfa.build(tree);
-    if (debug_mode)
-      nfa.print();
+  // run checker, under check mode rules when also generating tests so the
+  // alerts and their examples match a check mode run
+  if (check_mode) {
+    Util::get()->set_check_mode(true);
+    Checker checker(paths, scanner.get_tokens(), nfa);
+    checker.check();
     if (stat_mode)
-      nfa.add_stats(stats);
-
-    // traverse NFA basis paths and process them
-    std::vector<Path> paths = nfa.find_basis_paths();
-    for (auto &path : paths) {
-      path.process_path();
+      checker.add_stats(stats);
+    if (gen_mode) {
+      Util::get()->set_check_mode(false);
+      nfa.reset();
+      for (Path &path : paths)
+        path.reset();
     }
+  }
+
+  // time backtracking growth of each repetition
+  if (timing_mode) {
+    BacktrackTimer timer(regex, nfa, repeat_spans);
+    timer.measure();
+    result.timings = timer.get_timings();
+    result.timing_error = timer.get_error();
+  }
 
-    // run checker
-    if (check_mode) {
-      Checker checker(paths, scanner.get_tokens());
-      checker.check();
+  // generate tests
+  if (gen_mode) {
+    TestGenerator gen(paths, punct_marks, debug_mode);
+    test_strings = gen.gen_test_strings();
+    if (stat_mode) {
+      gen.add_stats(stats);
+
+      // check the test strings against the DFA and measure coverage
+      DFA dfa(nfa);
+      for (const std::string &test_string : test_strings)
+        dfa.cover(test_string);
+      dfa.expand(MAX_DFA_STATES);
+      dfa.add_stats(stats);
     }
+  }
+
+  result.alerts = Util::get()->get_alerts();
+  return result;
+}
+
+std::vector<std::string> render_check_result(const EgretResult &result,
+                                             bool web_mode) {
+  std::vector<std::string> alerts;
+  for (const Alert &alert : result.alerts) {
+    if (!alert.warning || alert.incomplete)
+      alerts.push_back(alert.render(result.regex, web_mode));
+  }
+  if (alerts.empty()) {
+    alerts.push_back("No violations detected.");
+  }
+  return alerts;
+}
+
+std::vector<std::string> render_gen_result(const EgretResult &result,
+                                           bool web_mode) {
+  std::vector<std::string> strs;
+  for (const Alert &alert : result.alerts) {
+    if (alert.warning)
+      strs.push_back(alert.render(result.regex, web_mode));
+  }
+  strs.push_back("BEGIN");
+  strs.insert(strs.end(), result.test_strings.begin(),
+              result.test_strings.end());
+  return strs;
+}
 
-    // generate tests
-    if (!check_mode) {
-      TestGenerator gen(paths, punct_marks, debug_mode);
-      test_strings = gen.gen_test_strings();
-      if (stat_mode)
-        gen.add_stats(stats);
+std::vector<std::string> render_timing_result(const EgretResult &result) {
+  std::vector<std::string> lines(1, "Backtracking growth:");
+  if (!result.timing_error.empty()) {
+    lines.push_back("  " + result.timing_error);
+    return lines;
+  }
+  if (result.timings.empty()) {
+    lines.push_back("  no unbounded repetitions");
+    return lines;
+  }
+
+  for (const RepeatTiming &timing : result.timings) {
+    std::stringstream s;
+    s << "  ";
+    if (timing.loc.first != -1)
+      s << timing.subexpr << " at " << timing.loc.first;
+    else
+      s << "repetition";
+    s << ": " << timing.growth;
+    if (!timing.samples.empty()) {
+      auto last = timing.samples.back();
+      s << " (" << last.first << " pumps of \"" << timing.pump << "\" took "
+        << std::fixed << std::setprecision(6) << last.second << "s)";
     }
+    lines.push_back(s.str());
+  }
+  return lines;
+}
 
-    // print stats
-    if (stat_mode)
-      stats.print();
+EgretResult run_engine_result(const std::string &regex,
+                              const std::string &base_substring,
+                              bool check_mode, bool debug_mode,
+                              bool stat_mode, bool timing_mode,
+                              unsigned int max_alerts,
+                              unsigned int max_repeat) {
+  try {
+    return run_pipeline(regex, base_substring, check_mode, !check_mode,
+                        debug_mode, stat_mode, timing_mode, max_alerts,
+                        max_repeat);
   } catch (EgretException const &e) {
     throw std::runtime_error(e.get_error());
   }
+}
 
-  // Add alerts to front of list.
-  std::vector<std::string> alerts = Util::get()->get_alerts();
-  if (check_mode) {
-    if (alerts.empty()) {
-      alerts.insert(alerts.begin(), "No violations detected.");
+std::vector<std::string>
+run_engine(const std::string &regex, const std::string &base_substring,
+           bool check_mode, bool web_mode, bool debug_mode, bool stat_mode,
+           bool timing_mode, unsigned int max_alerts,
+           unsigned int max_repeat) {
+  EgretResult result;
+
+  try {
+    result = run_pipeline(regex, base_substring, check_mode, !check_mode,
+                          debug_mode, stat_mode, timing_mode, max_alerts,
+                          max_repeat);
+  } catch (EgretException const &e) {
+    throw std::runtime_error(e.get_error());
+  }
+
+  // print stats
+  if (stat_mode)
+    result.stats.print();
+
+  std::vector<std::string> lines;
+  if (timing_mode)
+    lines = render_timing_result(result);
+  std::vector<std::string> rendered =
+      check_mode ? render_check_result(result, web_mode)
+                 : render_gen_result(result, web_mode);
+  lines.insert(lines.end(), rendered.begin(), rendered.end());
+  return lines;
+}
+
+std::pair<std::vector<std::string>, std::vector<std::string>>
+run_engine_combined(const std::string &regex,
+                    const std::string &base_substring, bool web_mode,
+                    bool debug_mode, bool stat_mode) {
+  EgretResult result;
+
+  try {
+    result = run_pipeline(regex, base_substring, true, true, debug_mode,
+                          stat_mode, false, 0, DEFAULT_MAX_REPEAT);
+  } catch (EgretException const &gen_error) {
+    // Some escapes are only supported in check mode, so the checker may
+    // still be able to run on its own.
+    try {
+      result = run_pipeline(regex, base_substring, true, false, debug_mode,
+                            stat_mode, false, 0, DEFAULT_MAX_REPEAT);
+    } catch (EgretException const &e) {
+      throw std::runtime_error(gen_error.get_error());
     }
-    return alerts;
+    if (stat_mode)
+      result.stats.print();
+    return std::make_pair(render_check_result(result, web_mode),
+                          std::vector<std::string>(1, gen_error.get_error()));
   }
-  test_strings.insert(test_strings.begin(), "BEGIN");
-  test_strings.insert(test_strings.begin(), alerts.begin(), alerts.end());
 
-  return test_strings;
+  if (stat_mode)
+    result.stats.print();
+  return std::make_pair(render_check_result(result, web_mode),
+                        render_gen_result(result, web_mode));
 }
@@ -22,13 +22,61 @@
 #ifndef EGRET_H
 #define EGRET_H
 
+#include "Stats.h"
+#include "Util.h"
 #include <string>
+#include <utility>
 #include <vector>
 
-// run_engine: entry point into EGRET engine
+// EgretResult: alerts, test strings and stats from one run of the engine
+struct EgretResult {
+  std::string regex;                     // regex that was run
+  std::vector<Alert> alerts;             // warnings and violations
+  std::vector<std::string> test_strings; // test strings in generation order
+  Stats stats;                           // stats (if stat mode is set)
+  std::vector<RepeatTiming> timings;     // growth (if timing mode is set)
+  std::string timing_error;              // set if growth could not be timed
+};
+
+// run_engine: entry point into EGRET engine, a nonzero max_alerts stops
+// checking once that many violations are found, a nonzero max_repeat is the
+// most loop iterations written out in a test string for large repeat bounds
 std::vector<std::string>
 run_engine(const std::string &regex, const std::string &base_substring,
            bool check_mode = false, bool web_mode = false,
-           bool debug_mode = false, bool stat_mode = false);
+           bool debug_mode = false, bool stat_mode = false,
+           bool timing_mode = false, unsigned int max_alerts = 0,
+           unsigned int max_repeat = DEFAULT_MAX_REPEAT);
+
+// run_engine_result: entry point returning a structured result, takes the
+// options of run_engine in the same order, errors are thrown as
+// std::runtime_error
+EgretResult run_engine_result(const std::string &regex,
+                              const std::string &base_substring,
+                              bool check_mode = false, bool debug_mode = false,
+                              bool stat_mode = false, bool timing_mode = false,
+                              unsigned int max_alerts = 0,
+                              unsigned int max_repeat = DEFAULT_MAX_REPEAT);
+
+// render_check_result: renders the violations as returned in check mode
+std::vector<std::string> render_check_result(const EgretResult &result,
+                                             bool web_mode = false);
+
+// render_timing_result: renders the backtracking growth of each repetition
+// as returned in timing mode
+std::vector<std::string> render_timing_result(const EgretResult &result);
+
+// render_gen_result: renders the warnings and test strings as returned in
+// test generation mode
+std::vector<std::string> render_gen_result(const EgretResult &result,
+                                           bool web_mode = false);
+
+// run_engine_combined: runs the checker and the test generator on a single
+// pipeline, returns the check mode and the test generation mode results, the
+// same as separate check mode and test generation mode runs
+std::pair<std::vector<std::string>, std::vector<std::string>>
+run_engine_combined(const std::string &regex,
+                    const std::string &base_substring, bool web_mode = false,
+                    bool debug_mode = false, bool stat_mode = false);
 
 #endif // EGRET_H
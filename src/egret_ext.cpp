@@ -19,14 +19,132 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include "egret.h"
+#define PY_SSIZE_T_CLEAN
 #include <Python.h>
+#include "CompiledRegex.h"
+#include "egret.h"
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 using namespace std;
 
 static PyObject *EgretExtError;
 
+static PyObject *make_str(const string &str) {
+  // alert markup and locations can split a multibyte character, so don't
+  // fail on it
+  return PyUnicode_DecodeUTF8(str.c_str(), str.length(), "replace");
+}
+
+static PyObject *make_list(const vector<string> &strs) {
+  PyObject *list = PyList_New(0);
+  vector<string>::const_iterator it;
+  for (it = strs.begin(); it != strs.end(); it++) {
+    PyObject *str = make_str(*it);
+    PyList_Append(list, str);
+    Py_DECREF(str);
+  }
+
+  return list;
+}
+
+// adds an item to a dictionary, taking the reference to the value
+static void set_item(PyObject *dict, const char *key, PyObject *value) {
+  PyDict_SetItemString(dict, key, value);
+  Py_DECREF(value);
+}
+
+static PyObject *make_loc(Location loc) {
+  if (loc.first == -1)
+    Py_RETURN_NONE;
+  return Py_BuildValue("(ii)", loc.first, loc.second);
+}
+
+static PyObject *make_alert(const Alert &alert) {
+  PyObject *dict = PyDict_New();
+  set_item(dict, "warning", PyBool_FromLong(alert.warning));
+  set_item(dict, "type", make_str(alert.type));
+  set_item(dict, "message", make_str(alert.message));
+
+  PyObject *details = PyList_New(0);
+  for (auto &detail : alert.details) {
+    PyObject *label = make_str(detail.first);
+    PyObject *value = make_str(detail.second);
+    PyObject *pair = PyTuple_Pack(2, label, value);
+    Py_DECREF(label);
+    Py_DECREF(value);
+    PyList_Append(details, pair);
+    Py_DECREF(pair);
+  }
+  set_item(dict, "details", details);
+
+  if (alert.has_suggest)
+    set_item(dict, "suggest", make_str(alert.suggest));
+  else
+    PyDict_SetItemString(dict, "suggest", Py_None);
+  if (alert.has_example)
+    set_item(dict, "example", make_str(alert.example));
+  else
+    PyDict_SetItemString(dict, "example", Py_None);
+  set_item(dict, "loc1", make_loc(alert.loc1));
+  set_item(dict, "loc2", make_loc(alert.loc2));
+  return dict;
+}
+
+static PyObject *make_timing(const RepeatTiming &timing) {
+  PyObject *dict = PyDict_New();
+  set_item(dict, "loc", make_loc(timing.loc));
+  set_item(dict, "subexpr", make_str(timing.subexpr));
+  set_item(dict, "pump", make_str(timing.pump));
+  set_item(dict, "exponential", PyBool_FromLong(timing.exponential));
+
+  PyObject *samples = PyList_New(0);
+  for (auto &sample : timing.samples) {
+    PyObject *item = Py_BuildValue("(Id)", sample.first, sample.second);
+    PyList_Append(samples, item);
+    Py_DECREF(item);
+  }
+  set_item(dict, "samples", samples);
+  set_item(dict, "growth", make_str(timing.growth));
+  return dict;
+}
+
+static PyObject *make_result(const EgretResult &result) {
+  PyObject *dict = PyDict_New();
+
+  PyObject *alerts = PyList_New(0);
+  for (const Alert &alert : result.alerts) {
+    PyObject *item = make_alert(alert);
+    PyList_Append(alerts, item);
+    Py_DECREF(item);
+  }
+  set_item(dict, "alerts", alerts);
+  set_item(dict, "test_strings", make_list(result.test_strings));
+
+  PyObject *stats = PyList_New(0);
+  for (const Stats::Stat &stat : result.stats.get_stats()) {
+    PyObject *item = Py_BuildValue("(ssl)", stat.tag.c_str(),
+                                   stat.name.c_str(), stat.value);
+    PyList_Append(stats, item);
+    Py_DECREF(item);
+  }
+  set_item(dict, "stats", stats);
+
+  PyObject *timings = PyList_New(0);
+  for (const RepeatTiming &timing : result.timings) {
+    PyObject *item = make_timing(timing);
+    PyList_Append(timings, item);
+    Py_DECREF(item);
+  }
+  set_item(dict, "timings", timings);
+  if (result.timing_error.empty())
+    PyDict_SetItemString(dict, "timing_error", Py_None);
+  else
+    set_item(dict, "timing_error", make_str(result.timing_error));
+  return dict;
+}
+
 static PyObject *egret_run(PyObject *self, PyObject *args) {
   const char *regex;
   const char *base_substring;
@@ -39,20 +157,233 @@ static PyObject *egret_run(PyObject *self, PyObject *args) {
                         &web_mode, &debug_mode, &stat_mode))
     return NULL;
 
-  vector<string> tests = run_engine(regex, base_substring, check_mode, web_mode,
-                                    debug_mode, stat_mode);
+  vector<string> tests;
+  try {
+    tests = run_engine(regex, base_substring, check_mode, web_mode, debug_mode,
+                       stat_mode);
+  } catch (runtime_error const &e) {
+    tests = vector<string>(1, e.what());
+  }
 
-  PyObject *list = PyList_New(0);
-  vector<string>::iterator it;
-  for (it = tests.begin(); it != tests.end(); it++) {
-    PyList_Append(list, PyUnicode_FromString((*it).c_str()));
+  return make_list(tests);
+}
+
+static PyObject *egret_analyze(PyObject *self, PyObject *args) {
+  const char *regex;
+  const char *base_substring;
+  int check_mode;
+  int debug_mode = 0;
+  int stat_mode = 0;
+  int timing_mode = 0;
+  unsigned int max_alerts = 0;
+  unsigned int max_repeat = DEFAULT_MAX_REPEAT;
+
+  if (!PyArg_ParseTuple(args, "ssp|pppII", &regex, &base_substring,
+                        &check_mode, &debug_mode, &stat_mode, &timing_mode,
+                        &max_alerts, &max_repeat))
+    return NULL;
+
+  EgretResult result;
+  try {
+    result = run_engine_result(regex, base_substring, check_mode, debug_mode,
+                               stat_mode, timing_mode, max_alerts, max_repeat);
+  } catch (runtime_error const &e) {
+    PyErr_SetString(EgretExtError, e.what());
+    return NULL;
   }
 
-  return list;
+  return make_result(result);
+}
+
+static PyObject *egret_run_combined(PyObject *self, PyObject *args) {
+  const char *regex;
+  const char *base_substring;
+  int web_mode;
+  int debug_mode;
+  int stat_mode;
+
+  if (!PyArg_ParseTuple(args, "ssppp", &regex, &base_substring, &web_mode,
+                        &debug_mode, &stat_mode))
+    return NULL;
+
+  pair<vector<string>, vector<string>> results;
+  try {
+    results = run_engine_combined(regex, base_substring, web_mode, debug_mode,
+                                  stat_mode);
+  } catch (runtime_error const &e) {
+    results.first = vector<string>(1, e.what());
+    results.second = results.first;
+  }
+
+  PyObject *check_list = make_list(results.first);
+  PyObject *gen_list = make_list(results.second);
+  PyObject *tuple = Py_BuildValue("(OO)", check_list, gen_list);
+  Py_DECREF(check_list);
+  Py_DECREF(gen_list);
+  return tuple;
+}
+
+// egret_ext.Regex: compiled regex that answers repeated queries
+
+typedef struct {
+  PyObject_HEAD
+  CompiledRegex *compiled;
+} RegexObject;
+
+static void Regex_dealloc(RegexObject *self) {
+  delete self->compiled;
+  Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static int Regex_init(RegexObject *self, PyObject *args, PyObject *kwds) {
+  const char *regex;
+  static const char *kwlist[] = {"regex", NULL};
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwds, "s", (char **)kwlist, &regex))
+    return -1;
+
+  delete self->compiled;
+  self->compiled = NULL;
+  try {
+    self->compiled = new CompiledRegex(regex);
+  } catch (runtime_error const &e) {
+    PyErr_SetString(EgretExtError, e.what());
+    return -1;
+  }
+
+  return 0;
+}
+
+static bool Regex_compiled(RegexObject *self) {
+  if (self->compiled == NULL) {
+    PyErr_SetString(EgretExtError, "regex is not compiled");
+    return false;
+  }
+  return true;
+}
+
+static PyObject *Regex_check(RegexObject *self, PyObject *args) {
+  const char *base_substring = "evil";
+
+  if (!PyArg_ParseTuple(args, "|s", &base_substring) || !Regex_compiled(self))
+    return NULL;
+
+  EgretResult result;
+  try {
+    result = self->compiled->check(base_substring);
+  } catch (runtime_error const &e) {
+    PyErr_SetString(EgretExtError, e.what());
+    return NULL;
+  }
+
+  return make_result(result);
+}
+
+static PyObject *Regex_generate(RegexObject *self, PyObject *args) {
+  const char *base_substring = "evil";
+  unsigned int max_strings = 0;
+
+  if (!PyArg_ParseTuple(args, "|sI", &base_substring, &max_strings) ||
+      !Regex_compiled(self))
+    return NULL;
+
+  EgretResult result;
+  try {
+    result = self->compiled->generate(base_substring, max_strings);
+  } catch (runtime_error const &e) {
+    PyErr_SetString(EgretExtError, e.what());
+    return NULL;
+  }
+
+  return make_result(result);
+}
+
+static PyObject *Regex_start_generate(RegexObject *self, PyObject *args) {
+  const char *base_substring = "evil";
+
+  if (!PyArg_ParseTuple(args, "|s", &base_substring) || !Regex_compiled(self))
+    return NULL;
+
+  try {
+    self->compiled->start_generate(base_substring);
+  } catch (runtime_error const &e) {
+    PyErr_SetString(EgretExtError, e.what());
+    return NULL;
+  }
+  Py_RETURN_NONE;
 }
 
+static PyObject *Regex_next_test_string(RegexObject *self,
+                                        PyObject *Py_UNUSED(args)) {
+  if (!Regex_compiled(self))
+    return NULL;
+
+  string test_string;
+  try {
+    if (!self->compiled->next_test_string(test_string))
+      Py_RETURN_NONE;
+  } catch (runtime_error const &e) {
+    PyErr_SetString(EgretExtError, e.what());
+    return NULL;
+  }
+  return make_str(test_string);
+}
+
+static PyObject *Regex_match(RegexObject *self, PyObject *args) {
+  const char *str;
+  Py_ssize_t len;
+
+  if (!PyArg_ParseTuple(args, "s#", &str, &len) || !Regex_compiled(self))
+    return NULL;
+
+  bool matched;
+  try {
+    matched = self->compiled->match(string(str, len));
+  } catch (runtime_error const &e) {
+    PyErr_SetString(EgretExtError, e.what());
+    return NULL;
+  }
+  return PyBool_FromLong(matched);
+}
+
+static PyObject *Regex_reset(RegexObject *self, PyObject *Py_UNUSED(args)) {
+  if (!Regex_compiled(self))
+    return NULL;
+
+  self->compiled->reset();
+  Py_RETURN_NONE;
+}
+
+static PyMethodDef Regex_methods[] = {
+    {"check", (PyCFunction)Regex_check, METH_VARARGS,
+     "Run the checker, returns the violations."},
+    {"generate", (PyCFunction)Regex_generate, METH_VARARGS,
+     "Generate test strings using the given base substring, returns the "
+     "warnings and test strings in generation order. A nonzero maximum "
+     "stops after that many strings, which are the first ones "
+     "next_test_string returns."},
+    {"start_generate", (PyCFunction)Regex_start_generate, METH_VARARGS,
+     "Start generating test strings using the given base substring."},
+    {"next_test_string", (PyCFunction)Regex_next_test_string, METH_NOARGS,
+     "Return the next generated test string, in the same order as "
+     "generate, None once there are none left."},
+    {"match", (PyCFunction)Regex_match, METH_VARARGS,
+     "Return True if the regex matches the entire string. Raises\n"
+     "egret_ext.error if the regex cannot be matched exactly."},
+    {"reset", (PyCFunction)Regex_reset, METH_NOARGS,
+     "Clear the state left by the previous query."},
+    {NULL, NULL, 0, NULL} /* Sentinel */
+};
+
+static PyTypeObject RegexType = {PyVarObject_HEAD_INIT(NULL, 0)};
+
 static PyMethodDef EgretExtMethods[] = {
     {"run", egret_run, METH_VARARGS, "Run EGRET."},
+    {"analyze", egret_analyze, METH_VARARGS,
+     "Run EGRET, returns the alerts, test strings, stats and backtracking "
+     "timings."},
+    {"run_combined", egret_run_combined, METH_VARARGS,
+     "Run EGRET check mode and test generation on a single pipeline."},
     {NULL, NULL, 0, NULL} /* Sentinel */
 };
 
@@ -68,10 +399,24 @@ extern "C" {
 PyMODINIT_FUNC PyInit_egret_ext(void) {
   PyObject *m;
 
+  RegexType.tp_name = "egret_ext.Regex";
+  RegexType.tp_doc = "Regex compiled once for repeated EGRET queries.";
+  RegexType.tp_basicsize = sizeof(RegexObject);
+  RegexType.tp_flags = Py_TPFLAGS_DEFAULT;
+  RegexType.tp_new = PyType_GenericNew;
+  RegexType.tp_init = (initproc)Regex_init;
+  RegexType.tp_dealloc = (destructor)Regex_dealloc;
+  RegexType.tp_methods = Regex_methods;
+  if (PyType_Ready(&RegexType) < 0)
+    return NULL;
+
   m = PyModule_Create(&egret_extmodule);
   if (m == NULL)
     return NULL;
 
+  Py_INCREF(&RegexType);
+  PyModule_AddObject(m, "Regex", (PyObject *)&RegexType);
+
   EgretExtError = PyErr_NewException("egret_ext.error", NULL, NULL);
   Py_INCREF(EgretExtError);
   PyModule_AddObject(m, "error", EgretExtError);
@@ -20,6 +20,7 @@
 */
 
 #include "egret.h"
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
@@ -38,6 +39,9 @@ int main(int argc, char *argv[]) {
   bool web_mode = false;
   bool debug_mode = false;
   bool stat_mode = false;
+  bool timing_mode = false;
+  int max_alerts = 0;
+  int max_repeat = DEFAULT_MAX_REPEAT;
 
   // Process arguments
   while (idx < argc) {
@@ -90,11 +94,36 @@ int main(int argc, char *argv[]) {
       debug_mode = true;
     }
 
+    // -i: most loop iterations written out for large repeat bounds (0 for
+    // no limit)
+    else if (strcmp(arg, "-i") == 0) {
+      max_repeat = atoi(get_arg(idx, argc, argv));
+      if (max_repeat < 0) {
+        cerr << "USAGE: Maximum number of iterations cannot be negative"
+             << endl;
+        return -1;
+      }
+    }
+
+    // -m: stop checking after the given number of violations
+    else if (strcmp(arg, "-m") == 0) {
+      max_alerts = atoi(get_arg(idx, argc, argv));
+      if (max_alerts <= 0) {
+        cerr << "USAGE: Maximum number of violations must be positive" << endl;
+        return -1;
+      }
+    }
+
     // -s: print stats
     else if (strcmp(arg, "-s") == 0) {
       stat_mode = true;
     }
 
+    // -t: time backtracking growth of each repetition
+    else if (strcmp(arg, "-t") == 0) {
+      timing_mode = true;
+    }
+
     // -w: run web mode
     else if (strcmp(arg, "-w") == 0) {
       web_mode = true;
@@ -113,7 +142,9 @@ int main(int argc, char *argv[]) {
   }
 
   vector<string> test_strings = run_engine(regex, base_substring, check_mode,
-                                           web_mode, debug_mode, stat_mode);
+                                           web_mode, debug_mode, stat_mode,
+                                           timing_mode, max_alerts,
+                                           max_repeat);
 
   vector<string>::iterator it;
   for (it = test_strings.begin(); it != test_strings.end(); it++) {
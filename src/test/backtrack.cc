@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "egret/BacktrackTimer.h"
+#include "egret/egret.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+static bool has_alert(const std::vector<std::string> &alerts,
+                      const std::string &type) {
+  for (const std::string &alert : alerts) {
+    if (alert.find("(" + type + ")") != std::string::npos)
+      return true;
+  }
+  return false;
+}
+
+TEST(Backtrack, nested_quantifiers) {
+  std::vector<std::string> alerts = run_engine("(a+)+", "evil", true);
+  EXPECT_TRUE(has_alert(alerts, "exponential backtracking"));
+}
+
+TEST(Backtrack, overlapping_alternation) {
+  std::vector<std::string> alerts = run_engine("(a|a)*", "evil", true);
+  EXPECT_TRUE(has_alert(alerts, "exponential backtracking"));
+}
+
+TEST(Backtrack, adjacent_repetitions) {
+  std::vector<std::string> alerts = run_engine("\\d+\\d+", "evil", true);
+  EXPECT_TRUE(has_alert(alerts, "polynomial backtracking"));
+}
+
+TEST(Backtrack, unambiguous) {
+  std::vector<std::string> alerts = run_engine("(a|ab)*c", "evil", true);
+  EXPECT_FALSE(has_alert(alerts, "exponential backtracking"));
+  EXPECT_FALSE(has_alert(alerts, "polynomial backtracking"));
+}
+
+TEST(Backtrack, search_limits) {
+  // nesting too deep for the product search is reported as incomplete
+  std::string regex = "a";
+  for (int i = 0; i < 100; i++)
+    regex = "(a" + regex + ")*";
+  std::vector<std::string> alerts = run_engine(regex, "evil", true);
+  EXPECT_TRUE(has_alert(alerts, "analysis incomplete"));
+  EXPECT_EQ(std::find(alerts.begin(), alerts.end(), "No violations detected."),
+            alerts.end());
+
+  EgretResult result = run_engine_result(regex, "evil", true, false, true);
+  bool found = false;
+  for (const Stats::Stat &stat : result.stats.get_stats()) {
+    if (stat.name == "Backtracking searches cut off") {
+      found = true;
+      EXPECT_GT(stat.value, 0);
+    }
+  }
+  EXPECT_TRUE(found);
+}
+
+static std::vector<std::pair<unsigned int, double>>
+gen_samples(double (*time)(double)) {
+  std::vector<std::pair<unsigned int, double>> samples;
+  for (unsigned int pumps = 1; pumps <= 12; pumps++)
+    samples.push_back(std::make_pair(pumps, time(pumps)));
+  return samples;
+}
+
+TEST(BacktrackTimer, fit_growth) {
+  EXPECT_EQ(BacktrackTimer::fit_growth(
+                gen_samples([](double n) { return 1e-6 * n; })),
+            "polynomial, degree 1.00");
+  EXPECT_EQ(BacktrackTimer::fit_growth(
+                gen_samples([](double n) { return 1e-6 * n * n * n; })),
+            "polynomial, degree 3.00");
+  EXPECT_EQ(BacktrackTimer::fit_growth(
+                gen_samples([](double n) { return 1e-6 * std::pow(2, n); })),
+            "exponential, x2.00 per pump");
+
+  // too few slow samples --> all measured samples are fitted
+  std::vector<std::pair<unsigned int, double>> samples = {
+      {1, 1e-6}, {2, 1e-6}, {3, 1e-6}, {4, 1e-3}};
+  EXPECT_NE(BacktrackTimer::fit_growth(samples), "not enough samples");
+  samples = {{1, 0}, {2, 1e-6}};
+  EXPECT_EQ(BacktrackTimer::fit_growth(samples), "not enough samples");
+}
+
+TEST(BacktrackTimer, bounded_time) {
+  auto start = std::chrono::steady_clock::now();
+  EgretResult result =
+      run_engine_result("(a|a)*$", "evil", true, false, false, true);
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  EXPECT_LT(seconds, 10.0);
+  ASSERT_EQ(result.timings.size(), 1u);
+  const RepeatTiming &timing = result.timings[0];
+  EXPECT_EQ(timing.subexpr, "(a|a)*");
+  EXPECT_EQ(timing.loc, std::make_pair(0, 5));
+  EXPECT_EQ(timing.growth.find("exponential"), 0u);
+}
+
+TEST(BacktrackTimer, quadratic_degree) {
+  EgretResult result =
+      run_engine_result("\\d*\\d*x", "evil", true, false, false, true);
+  ASSERT_FALSE(result.timings.empty());
+  const std::string &growth = result.timings[0].growth;
+  const std::string poly = "polynomial, degree ";
+  ASSERT_EQ(growth.find(poly), 0u) << growth;
+  double degree = std::stod(growth.substr(poly.size()));
+  EXPECT_GT(degree, 1.6) << growth;
+  EXPECT_LT(degree, 2.5) << growth;
+}
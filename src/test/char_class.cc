@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include "egret/CharClass.h"
+#include "egret/CharSet.h"
+#include <cctype>
+#include <string>
+
+// the tables must agree with the C locale ctype functions
+TEST(CharClass, matches_ctype) {
+  for (int i = 0; i < 256; i++) {
+    char c = (char)i;
+    EXPECT_EQ(is_punct_char(c), i < 128 && ispunct(i) != 0) << i;
+    EXPECT_EQ(is_space_char(c), i < 128 && isspace(i) != 0) << i;
+    EXPECT_EQ(is_digit_char(c), i < 128 && isdigit(i) != 0) << i;
+    EXPECT_EQ(is_lower_char(c), i < 128 && islower(i) != 0) << i;
+    EXPECT_EQ(is_upper_char(c), i < 128 && isupper(i) != 0) << i;
+  }
+}
+
+TEST(CharClass, classes) {
+  for (int i = 0; i < 256; i++) {
+    char c = (char)i;
+    bool word = i < 128 && (isalnum(i) || c == '_');
+    EXPECT_EQ(in_char_class('w', c), word) << i;
+    EXPECT_EQ(in_char_class('W', c), !word) << i;
+    EXPECT_EQ(in_char_class('d', c), i < 128 && isdigit(i) != 0) << i;
+    EXPECT_EQ(in_char_class('D', c), !(i < 128 && isdigit(i))) << i;
+    EXPECT_EQ(in_char_class('s', c), c == ' ') << i;
+    EXPECT_EQ(in_char_class('S', c), c != ' ') << i;
+    EXPECT_TRUE(in_char_class('.', c)) << i;
+  }
+  EXPECT_EQ(class_item_flag('x'), 0u);
+}
+
+// every character the scanner treats specially must be in the table
+TEST(CharClass, special_chars) {
+  const std::string special = "\\[]-|*+?(){.^$";
+  for (int i = 0; i < 256; i++) {
+    char c = (char)i;
+    EXPECT_EQ(is_special_char(c), special.find(c) != std::string::npos) << i;
+  }
+}
+
+static CharSet make_range_set(char start, char end, bool complement) {
+  CharSet char_set;
+  CharSetItem item{};
+  item.type = CHAR_RANGE_ITEM;
+  item.range_start = start;
+  item.range_end = end;
+  char_set.add_item(item);
+  char_set.set_complement(complement);
+  return char_set;
+}
+
+TEST(CharSet, interned_sets) {
+  CharSetPool pool;
+  CharSet digits = make_range_set('0', '9', false);
+  CharSet same = make_range_set('0', '9', false);
+  CharSet not_digits = make_range_set('0', '9', true);
+  digits.intern(pool);
+  same.intern(pool);
+  not_digits.intern(pool);
+  EXPECT_EQ(pool.get_num_sets(), 2u);
+  EXPECT_EQ(pool.get_num_shared(), 1u);
+
+  EXPECT_TRUE(same.is_valid_character('5'));
+  EXPECT_FALSE(same.is_valid_character('a'));
+  EXPECT_FALSE(not_digits.is_valid_character('5'));
+  EXPECT_TRUE(not_digits.is_valid_character('a'));
+
+  // changing a shared set does not affect the others
+  CharSetItem item{};
+  item.type = CHARACTER_ITEM;
+  item.character = 'a';
+  same.add_item(item);
+  EXPECT_TRUE(same.is_valid_character('a'));
+  EXPECT_FALSE(digits.is_valid_character('a'));
+}
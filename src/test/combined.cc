@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+#include "egret/egret.h"
+#include <algorithm>
+
+TEST(Combined, matches_separate_runs) {
+  std::string regex = "(a+)+b|c\\b";
+  auto results = run_engine_combined(regex, "evil");
+  EXPECT_EQ(results.second, run_engine(regex, "evil", false));
+  EXPECT_EQ(results.first, run_engine(regex, "evil", true));
+}
+
+TEST(Combined, check_examples_match_check_mode) {
+  // examples of char set repetitions are picked by check mode rules
+  std::vector<std::string> regexes = {
+      "[A-Za-z0-9._%+-]+@[A-Za-z0-9.-]+\\.[a-zA-Z]{2,}",
+      "^\\(?\\d{3}\\)?[-. ]?\\d{3}[-. ]?\\d{4}$",
+      "([\\+\\-\\/\\*]*[0-9]+)([a-z_]+[\\+\\-\\/\\*]*)"};
+  for (const std::string &regex : regexes) {
+    auto results = run_engine_combined(regex, "evil");
+    EXPECT_EQ(results.first, run_engine(regex, "evil", true)) << regex;
+    EXPECT_EQ(results.second, run_engine(regex, "evil", false)) << regex;
+  }
+}
+
+TEST(Combined, no_violations) {
+  auto results = run_engine_combined("abc", "evil");
+  EXPECT_EQ(results.first,
+            std::vector<std::string>(1, "No violations detected."));
+  EXPECT_NE(std::find(results.second.begin(), results.second.end(), "abc"),
+            results.second.end());
+}
+
+TEST(Combined, check_only_escape) {
+  auto results = run_engine_combined("a\\nb", "evil");
+  EXPECT_EQ(results.first, run_engine("a\\nb", "evil", true));
+  ASSERT_EQ(results.second.size(), 1u);
+  EXPECT_EQ(results.second[0].substr(0, 5), "ERROR");
+}
+
+TEST(Combined, error) {
+  EXPECT_THROW(run_engine_combined("a(", "evil"), std::runtime_error);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include "egret/CompiledRegex.h"
+#include "egret/egret.h"
+#include "egret/Util.h"
+
+TEST(CompiledRegex, repeated_queries) {
+  std::string regex = "^(a+)+b|[a-z.]*@x\\.com";
+  CompiledRegex compiled(regex);
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(render_check_result(compiled.check()),
+              run_engine(regex, "evil", true));
+    EXPECT_EQ(render_gen_result(compiled.generate("evil")),
+              run_engine(regex, "evil", false));
+    EXPECT_EQ(render_gen_result(compiled.generate("good")),
+              run_engine(regex, "good", false));
+  }
+}
+
+TEST(CompiledRegex, match) {
+  CompiledRegex compiled("(ab|c){2,3}d");
+  EXPECT_TRUE(compiled.match("abcd"));
+  EXPECT_TRUE(compiled.match("ccabd"));
+  EXPECT_FALSE(compiled.match("cd"));
+  EXPECT_FALSE(compiled.match("ababababd"));
+
+  CompiledRegex backref("(a|b)c\\1");
+  EXPECT_TRUE(backref.match("aca"));
+  EXPECT_FALSE(backref.match("acb"));
+}
+
+TEST(CompiledRegex, inexact_match) {
+  // the DFA accepts these strings, std::regex decides instead
+  EXPECT_FALSE(CompiledRegex("x(?=y)").match("x"));
+  EXPECT_FALSE(CompiledRegex("a\\bb").match("ab"));
+  EXPECT_TRUE(CompiledRegex("\\s").match("\t"));
+  EXPECT_FALSE(CompiledRegex("(a|b)\\1").match("a"));
+
+  // std::regex does not support inline flags, the approximate answer is
+  // not returned
+  CompiledRegex flags("(?i)abc");
+  EXPECT_THROW(flags.match("ABC"), std::runtime_error);
+  EXPECT_THROW(flags.match("abc"), std::runtime_error);
+}
+
+TEST(CompiledRegex, errors) {
+  EXPECT_THROW(CompiledRegex("a("), std::runtime_error);
+
+  CompiledRegex check_only("a\\nb");
+  EXPECT_EQ(render_check_result(check_only.check()),
+            run_engine("a\\nb", "evil", true));
+  EXPECT_THROW(check_only.generate("evil"), std::runtime_error);
+  EXPECT_THROW(check_only.check("a1"), std::runtime_error);
+}
+
+TEST(CompiledRegex, lazy_generation) {
+  std::string regex = "(ab|c){2,3}d|[a-z]+@x\\.com";
+  CompiledRegex compiled(regex);
+  std::vector<std::string> all = compiled.generate("evil").test_strings;
+
+  // strings come in the same order as generate
+  compiled.start_generate("evil");
+  std::vector<std::string> lazy;
+  std::string test_string;
+  while (compiled.next_test_string(test_string)) {
+    lazy.push_back(test_string);
+
+    // other queries in between do not affect the strings
+    compiled.check();
+    run_engine("x+", "good", false);
+  }
+  EXPECT_EQ(lazy, all);
+
+  std::vector<std::string> first = compiled.generate("evil", 3).test_strings;
+  EXPECT_EQ(first, std::vector<std::string>(lazy.begin(), lazy.begin() + 3));
+
+  // pulling a string keeps the global options of the caller
+  compiled.start_generate("evil");
+  Util::get()->init("x+", false, "good", 0, 7);
+  ASSERT_TRUE(compiled.next_test_string(test_string));
+  EXPECT_EQ(Util::get()->get_max_repeat(), 7u);
+  EXPECT_EQ(Util::get()->get_base_substring(), "good");
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include "egret/CompiledRegex.h"
+#include "egret/DFA.h"
+#include "egret/NFA.h"
+#include "egret/ParseTree.h"
+#include "egret/Scanner.h"
+#include "egret/Util.h"
+
+static DFA build_dfa(const std::string &regex) {
+  Util::get()->init(regex, false, "evil");
+  Scanner scanner;
+  scanner.init(regex);
+  ParseTree tree;
+  tree.build(scanner);
+  NFA nfa;
+  nfa.build(tree);
+  nfa.optimize();
+  return DFA(nfa);
+}
+
+TEST(DFA, bounded_repeat) {
+  DFA dfa = build_dfa("a{2,3}");
+  EXPECT_FALSE(dfa.accepts("a"));
+  EXPECT_TRUE(dfa.accepts("aa"));
+  EXPECT_TRUE(dfa.accepts("aaa"));
+  EXPECT_FALSE(dfa.accepts("aaaa"));
+}
+
+TEST(DFA, nested_repeat) {
+  DFA dfa = build_dfa("(ab|c){2,}d?");
+  EXPECT_FALSE(dfa.accepts("ab"));
+  EXPECT_TRUE(dfa.accepts("abc"));
+  EXPECT_TRUE(dfa.accepts("cccabd"));
+  EXPECT_FALSE(dfa.accepts("abcdd"));
+  EXPECT_TRUE(dfa.is_exact());
+}
+
+TEST(DFA, anchors) {
+  // anchors at the ends match the whole string
+  EXPECT_TRUE(build_dfa("^ab$").is_exact());
+  EXPECT_TRUE(build_dfa("^a|b$").is_exact());
+
+  // anchors inside the regex are approximated
+  EXPECT_FALSE(build_dfa("a^b").is_exact());
+  EXPECT_FALSE(build_dfa("a$b").is_exact());
+  EXPECT_FALSE(build_dfa("(^a)*").is_exact());
+  EXPECT_FALSE(CompiledRegex("a^b").match("ab"));
+  EXPECT_FALSE(CompiledRegex("a$b").match("ab"));
+  EXPECT_TRUE(CompiledRegex("^ab$").match("ab"));
+}
+
+TEST(DFA, ignored_elements) {
+  // lookarounds, word boundaries and inline flags are approximated
+  EXPECT_FALSE(build_dfa("x(?=y)").is_exact());
+  EXPECT_FALSE(build_dfa("a\\bb").is_exact());
+  EXPECT_FALSE(build_dfa("a\\Bb").is_exact());
+  EXPECT_FALSE(build_dfa("(?i)abc").is_exact());
+  EXPECT_FALSE(CompiledRegex("x(?=y)").match("x"));
+  EXPECT_FALSE(CompiledRegex("a\\bb").match("ab"));
+}
+
+TEST(DFA, approximate_classes) {
+  // \s only matches a space, \S and . match every other character
+  EXPECT_FALSE(build_dfa("\\s").is_exact());
+  EXPECT_FALSE(build_dfa("\\S+").is_exact());
+  EXPECT_FALSE(build_dfa("a.b").is_exact());
+  EXPECT_FALSE(build_dfa("[^\\s]").is_exact());
+  EXPECT_TRUE(build_dfa("[\\w-]+\\d").is_exact());
+  EXPECT_TRUE(CompiledRegex("\\s").match("\t"));
+  EXPECT_FALSE(CompiledRegex("\\S").match("\n"));
+  EXPECT_FALSE(CompiledRegex("a.b").match("a\nb"));
+}
+
+TEST(DFA, coverage) {
+  DFA dfa = build_dfa("\\d+x");
+  EXPECT_TRUE(dfa.cover("12x"));
+  EXPECT_FALSE(dfa.cover("x"));
+  dfa.expand(MAX_DFA_STATES);
+  DFACoverage coverage = dfa.get_coverage();
+  EXPECT_EQ(coverage.states, coverage.covered_states);
+  EXPECT_EQ(coverage.transitions, coverage.covered_transitions);
+  EXPECT_EQ(dfa.get_num_classes(), 3u);
+}
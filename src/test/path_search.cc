@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "egret/NFA.h"
+#include "egret/ParseTree.h"
+#include "egret/Path.h"
+#include "egret/PathSearch.h"
+#include "egret/Scanner.h"
+#include "egret/Util.h"
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+static NFA build_nfa(const std::string &regex) {
+  Util::get()->init(regex, false, "evil");
+  Scanner scanner;
+  scanner.init(regex);
+  ParseTree tree;
+  tree.build(scanner);
+  NFA nfa;
+  nfa.build(tree);
+  nfa.optimize();
+  return nfa;
+}
+
+static std::vector<std::vector<unsigned int>>
+get_states(const std::vector<Path> &paths) {
+  std::vector<std::vector<unsigned int>> states;
+  for (const Path &path : paths)
+    states.push_back(path.get_states());
+  return states;
+}
+
+TEST(PathSearch, matches_estimate) {
+  NFA nfa = build_nfa("(a|b)+c?(d(e|f)*)+");
+  std::vector<Path> paths = nfa.find_basis_paths();
+  PathEstimate estimate = nfa.estimate_basis_paths();
+  ASSERT_EQ(paths.size(), estimate.paths);
+  unsigned long total_length = 0;
+  for (const Path &path : paths) {
+    EXPECT_EQ(path.get_states().front(), nfa.get_initial());
+    EXPECT_EQ(path.get_states().back(), nfa.get_final());
+    total_length += path.get_states().size() - 1;
+  }
+  EXPECT_EQ(total_length, estimate.total_length);
+}
+
+static void *estimate_paths(void *nfa) {
+  static PathEstimate estimate;
+  estimate = static_cast<NFA *>(nfa)->estimate_basis_paths();
+  return &estimate;
+}
+
+TEST(PathSearch, deep_estimate) {
+  // one state per character, estimated on a small stack so that recursing
+  // once per state would overflow it
+  NFA nfa = build_nfa(std::string(4000, 'a'));
+  pthread_attr_t attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, 128 * 1024);
+  pthread_t thread;
+  ASSERT_EQ(pthread_create(&thread, &attr, estimate_paths, &nfa), 0);
+  pthread_attr_destroy(&attr);
+  void *result;
+  pthread_join(thread, &result);
+  PathEstimate estimate = *static_cast<PathEstimate *>(result);
+  EXPECT_EQ(estimate.paths, 1u);
+  EXPECT_EQ(estimate.max_length, nfa.get_size() - 1);
+}
+
+TEST(PathSearch, same_paths_on_threads) {
+  // wide alternations split into many tasks
+  std::string regex;
+  for (int i = 0; i < 20; i++) {
+    regex += "(";
+    for (int j = 0; j < 20; j++)
+      regex += (j == 0 ? "" : "|") + std::to_string(j) + "x";
+    regex += ")?";
+  }
+  NFA nfa = build_nfa(regex);
+  std::vector<Path> serial = PathSearch(nfa).find_paths(1);
+  EXPECT_GT(serial.size(), PATH_TASK_GRAIN);
+  for (unsigned int threads = 2; threads <= 4; threads++) {
+    std::vector<Path> paths = PathSearch(nfa).find_paths(threads);
+    EXPECT_EQ(get_states(paths), get_states(serial));
+  }
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include "egret/egret.h"
+#include <algorithm>
+#include <set>
+
+TEST(Result, check_alerts) {
+  EgretResult result = run_engine_result("^a|b", "evil", true);
+  ASSERT_EQ(result.alerts.size(), 1u);
+  const Alert &alert = result.alerts[0];
+  EXPECT_FALSE(alert.warning);
+  EXPECT_EQ(alert.type, "anchor usage");
+  ASSERT_EQ(alert.details.size(), 2u);
+  EXPECT_EQ(alert.details[0].first, "String with ^ anchor");
+  EXPECT_EQ(alert.details[0].second, "a");
+  EXPECT_EQ(alert.details[1].second, "b");
+  EXPECT_TRUE(alert.has_suggest);
+  EXPECT_TRUE(result.test_strings.empty());
+}
+
+TEST(Result, locations_and_example) {
+  EgretResult result = run_engine_result("\\(?\\d{3}\\)?", "evil", true);
+  ASSERT_EQ(result.alerts.size(), 1u);
+  const Alert &alert = result.alerts[0];
+  EXPECT_EQ(alert.type, "optional brace");
+  EXPECT_EQ(alert.loc1, std::make_pair(0, 2));
+  EXPECT_EQ(alert.loc2, std::make_pair(8, 10));
+  ASSERT_TRUE(alert.has_example);
+  EXPECT_EQ(alert.example, "(000");
+  EXPECT_EQ(alert.render(result.regex, true),
+            render_check_result(result, true)[0]);
+}
+
+TEST(Result, gen_strings) {
+  EgretResult result = run_engine_result("a\\bc", "evil", false, false, true);
+  ASSERT_EQ(result.alerts.size(), 1u);
+  EXPECT_TRUE(result.alerts[0].warning);
+  EXPECT_NE(std::find(result.test_strings.begin(), result.test_strings.end(),
+                      "ac"),
+            result.test_strings.end());
+  EXPECT_FALSE(result.stats.get_stats().empty());
+  EXPECT_EQ(render_gen_result(result), run_engine("a\\bc", "evil", false));
+}
+
+TEST(Result, max_alerts) {
+  const char *regex = "a[A-z]*\\(?\\d{3}\\)?|b*b*";
+  EgretResult all = run_engine_result(regex, "evil", true);
+  ASSERT_GT(all.alerts.size(), 2u);
+
+  // the limited run reports a prefix of the full list
+  EgretResult first =
+      run_engine_result(regex, "evil", true, false, false, false, 1);
+  ASSERT_EQ(first.alerts.size(), 1u);
+  EXPECT_EQ(first.alerts[0].type, all.alerts[0].type);
+  EgretResult two =
+      run_engine_result(regex, "evil", true, false, false, false, 2);
+  ASSERT_EQ(two.alerts.size(), 2u);
+  EXPECT_EQ(two.alerts[1].type, all.alerts[1].type);
+  EXPECT_EQ(two.alerts[1].loc1, all.alerts[1].loc1);
+}
+
+TEST(Result, one_test_char_per_class) {
+  // a, b and c are treated the same by the regex, d is outside the set
+  EgretResult result = run_engine_result("[abc]x", "evil", false);
+  const std::vector<std::string> &strs = result.test_strings;
+  EXPECT_NE(std::find(strs.begin(), strs.end(), "dx"), strs.end());
+  EXPECT_EQ(std::count(strs.begin(), strs.end(), "ax") +
+                std::count(strs.begin(), strs.end(), "bx"),
+            1);
+}
+
+static std::set<std::string> gen_string_set(const std::string &regex) {
+  std::vector<std::string> strs =
+      run_engine_result(regex, "evil", false).test_strings;
+  return std::set<std::string>(strs.begin(), strs.end());
+}
+
+TEST(Result, single_char_alternation) {
+  // a|b|c is rewritten as a character set tested with the literals only
+  EXPECT_EQ(gen_string_set("x(a|b|c)y"),
+            std::set<std::string>({"xay", "xby", "xcy"}));
+  EXPECT_EQ(gen_string_set("(a|b)\\1"), std::set<std::string>({"aa", "ba"}));
+
+  // a repeated alternative keeps the whole alternation
+  EXPECT_EQ(gen_string_set("a|b|a"), std::set<std::string>({"a", "b"}));
+
+  // the stats count the nodes as parsed
+  EgretResult result = run_engine_result("(a|b)", "evil", false, false, true);
+  for (const Stats::Stat &stat : result.stats.get_stats()) {
+    if (stat.name == "Alternation nodes")
+      EXPECT_EQ(stat.value, 1);
+    if (stat.name == "Simplified nodes")
+      EXPECT_EQ(stat.value, 2);
+  }
+}
+
+TEST(Result, repeated_subexpression) {
+  // the second (\.)+ reuses the NFA of the first, alerts keep its location
+  EgretResult result = run_engine_result("(\\.)+x(\\.)+", "evil", true);
+  ASSERT_EQ(result.alerts.size(), 2u);
+  EXPECT_EQ(result.alerts[0].type, "repeat punctuation");
+  EXPECT_EQ(result.alerts[1].type, "repeat punctuation");
+  EXPECT_EQ(result.alerts[1].loc1.first - result.alerts[0].loc1.first, 6);
+  EXPECT_EQ(result.alerts[1].example, ".x...");
+}
+
+TEST(Result, backreference_follows_path) {
+  // each path repeats the text its own group matched
+  EgretResult result = run_engine_result("(a|bc)x\\1", "evil", false);
+  const std::vector<std::string> &strs = result.test_strings;
+  EXPECT_NE(std::find(strs.begin(), strs.end(), "axa"), strs.end());
+  EXPECT_NE(std::find(strs.begin(), strs.end(), "bcxbc"), strs.end());
+  EXPECT_EQ(std::find(strs.begin(), strs.end(), "bcxa"), strs.end());
+}
+
+TEST(Result, equivalent_paths) {
+  // both alternatives give the same strings, only the first generates them
+  EgretResult result =
+      run_engine_result("([a-z]+|[a-z]+)x", "evil", false, false, true);
+  long equivalent_paths = -1;
+  for (const Stats::Stat &stat : result.stats.get_stats()) {
+    if (stat.name == "Equivalent paths")
+      equivalent_paths = stat.value;
+  }
+  EXPECT_EQ(equivalent_paths, 1);
+  const std::vector<std::string> &strs = result.test_strings;
+  EXPECT_NE(std::find(strs.begin(), strs.end(), "evilx"), strs.end());
+  EXPECT_NE(std::find(strs.begin(), strs.end(), "x"), strs.end());
+}
+
+TEST(Result, large_repeat_sampled) {
+  // the upper bound is sampled, the strings at and past it are left out
+  EgretResult result =
+      run_engine_result("x(ab){1,100000}y", "evil", false, false, false, false,
+                        0, 10);
+  const std::vector<std::string> &strs = result.test_strings;
+  std::string limit = "x";
+  for (int i = 0; i < 10; i++)
+    limit += "ab";
+  limit += "y";
+  EXPECT_NE(std::find(strs.begin(), strs.end(), "xababy"), strs.end());
+  EXPECT_NE(std::find(strs.begin(), strs.end(), limit), strs.end());
+  for (const std::string &str : strs)
+    EXPECT_LE(str.size(), limit.size());
+  ASSERT_EQ(result.alerts.size(), 1u);
+  EXPECT_TRUE(result.alerts[0].warning);
+  EXPECT_EQ(result.alerts[0].type, "repeat bound");
+
+  // the output size does not depend on the bound
+  for (const char *regex : {"x(ab){1,100000}y", "x(ab){1,100000000}y",
+                            "(a{2,100000}b){1,100000}"}) {
+    size_t size = 0;
+    for (const std::string &str : run_engine(regex, "evil", false))
+      size += str.size() + 1;
+    EXPECT_LT(size, 20000u) << regex;
+  }
+}